@@ -2,9 +2,17 @@ import subprocess
 import math
 import json
 import argparse
+import hashlib
+import os
 import matplotlib.pyplot as plt
 import matplotlib.ticker as ticker
 
+# Directory of the simulator sources, whose content identifies the version of the binary.
+SOURCE_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# A point is abandoned if this many seeds do not give enough valid results.
+MAX_SEEDS = 100
+
 def run_simulation(command: str) -> list[bytes]:
     """
     Run the ns-3 simulation with the given command and return the output.
@@ -21,6 +29,105 @@ def run_simulation(command: str) -> list[bytes]:
     return output.splitlines()
 
 
+def get_simulator_version() -> str:
+    """
+    Hash the sources of the simulator, so results of different builds are never mixed.
+
+    Returns:
+        str: The SHA-256 of the headers, sources and build files, in a stable order.
+    """
+    digest = hashlib.sha256()
+    for root, dirs, files in os.walk(SOURCE_DIR):
+        dirs[:] = sorted(d for d in dirs if not d.startswith((".", "_")))
+        for name in sorted(files):
+            if name.endswith((".cc", ".h")) or name == "CMakeLists.txt":
+                path = os.path.join(root, name)
+                digest.update(os.path.relpath(path, SOURCE_DIR).encode())
+                with open(path, "rb") as f:
+                    digest.update(f.read())
+
+    return digest.hexdigest()
+
+
+class ResultCache:
+    """
+    Append-only store of the output of every simulation run, keyed by the hash of the simulator
+    version, the full command and the seed.
+
+    Every run is a JSON line of the cache file, so the file is never rewritten and an interrupted
+    sweep keeps the runs it completed. Averages are always recomputed from the raw outputs, so a
+    sweep can be extended or re-plotted without running again the (command, seed) pairs it
+    already has.
+    """
+
+    def __init__(self, filename: str | None) -> None:
+        """
+        Load the cache file.
+
+        Args:
+            filename (str): The cache file, or None to run every simulation again.
+        """
+        self.filename = filename
+        self.version = get_simulator_version()
+        self.runs = {}
+
+        if filename is None or not os.path.exists(filename):
+            return
+
+        with open(filename) as f:
+            for line in f:
+                try:
+                    run = json.loads(line)
+                    self.runs[run["key"]] = run["output"]
+                except (ValueError, KeyError):
+                    # A line truncated by an interrupted write is ignored.
+                    continue
+
+    def get_key(self, command: str, seed: int) -> str:
+        """
+        Compute the key of a run.
+
+        Args:
+            command (str): The simulator command, without the seed.
+            seed (int): The run number passed to --RngRun.
+
+        Returns:
+            str: The SHA-256 of the simulator version, the command and the seed.
+        """
+        identity = json.dumps({"version": self.version, "command": command, "seed": seed})
+        return hashlib.sha256(identity.encode()).hexdigest()
+
+    def run(self, command: str, seed: int) -> list[bytes]:
+        """
+        Return the output of a run, executing the simulation only if it is not cached.
+
+        Args:
+            command (str): The simulator command, without the seed.
+            seed (int): The run number passed to --RngRun.
+
+        Returns:
+            list: A list of output lines from the simulation.
+        """
+        key = self.get_key(command, seed)
+        if key in self.runs:
+            return [line.encode() for line in self.runs[key]]
+
+        output = run_simulation(f"{command} --RngRun={seed}")
+        lines = [line.decode(errors="replace") for line in output]
+        self.runs[key] = lines
+
+        if self.filename is not None:
+            with open(self.filename, "a") as f:
+                record = {"key": key, "version": self.version, "command": command, "seed": seed}
+                record["output"] = lines
+                f.write(json.dumps(record) + "\n")
+
+        return output
+
+
+cache = ResultCache(None)
+
+
 def save_benchmarks(filename: str, benchmarks: dict[int, float]) -> None:
     """
     Save benchmark results to a JSON file.
@@ -33,12 +140,13 @@ def save_benchmarks(filename: str, benchmarks: dict[int, float]) -> None:
         json.dump(benchmarks, f)
 
 
-def plot_benchmarks(filename: str) -> None:
+def plot_benchmarks(filename: str, protocol: str = "lr") -> None:
     """
     Plot benchmark results from JSON file.
 
     Args:
         filename (str): The file to plot.
+        protocol (str): The routing protocol of the benchmark, added to the title.
     """
     plot_labels = {
         "nodes-benchmark.json": {
@@ -51,11 +159,31 @@ def plot_benchmarks(filename: str) -> None:
             "ylabel": "Fails",
             "title": "Failures over speed (100 packets)",
         },
+        "speed-predictive-benchmark.json": {
+            "xlabel": "Speed of the node (m/s)",
+            "ylabel": "Fails",
+            "title": "Failures over speed with predictive reversal (100 packets)",
+        },
         "time-benchmark.json": {
             "xlabel": "Number of nodes",
             "ylabel": "Time (seconds)",
             "title": "Packet delivery time",
         },
+        "memory-benchmark.json": {
+            "xlabel": "Number of nodes",
+            "ylabel": "Bytes per node",
+            "title": "Resident memory per node",
+        },
+        "memory-slim-benchmark.json": {
+            "xlabel": "Number of nodes",
+            "ylabel": "Bytes per node",
+            "title": "Resident memory per node (slim)",
+        },
+        "startup-benchmark.json": {
+            "xlabel": "Number of nodes",
+            "ylabel": "Wall-clock time (seconds)",
+            "title": "Time to first event",
+        },
     }
     
     with open(filename) as f:
@@ -66,10 +194,10 @@ def plot_benchmarks(filename: str) -> None:
 
     plt.plot(x, y, marker="o")
 
-    labels = plot_labels.get(filename, {})
+    labels = plot_labels.get(filename.replace(f"-{protocol}.json", ".json"), {})
     plt.xlabel(labels.get("xlabel", ""))
     plt.ylabel(labels.get("ylabel", ""))
-    plt.title(labels.get("title", ""))
+    plt.title(labels.get("title", "") + ("" if protocol == "lr" else f" ({protocol.upper()})"))
 
     plt.savefig(filename.replace(".json", ".png"))
     plt.show()
@@ -82,6 +210,8 @@ def run_benchmark(
     filename: str,
     benchmark_name: str,
     plot: bool = False,
+    output_prefix: str | None = None,
+    protocol: str = "lr",
 ) -> None:
     """
     Run a benchmark by executing a simulation multiple times and averaging the results.
@@ -93,17 +223,37 @@ def run_benchmark(
         filename (str): The name of the file to save the benchmark results.
         benchmark_name (str): The name of the benchmark being run.
         plot (bool): Whether to plot the results after running the benchmark.
+        output_prefix (str): If set, the result is taken from the first output line starting with
+            this prefix instead of the line at output_index.
+        protocol (str): The routing protocol used by the simulator. The results of the protocols
+            other than link reversal are saved in a file with the protocol name as suffix.
     """
     benchmarks = {}
+    output_file = filename if protocol == "lr" else filename.replace(".json", f"-{protocol}.json")
 
     for value in parameter_values:
         command = command_template.format(value=value)
+        if protocol != "lr":
+            command += f" --protocol={protocol}"
         results = []
 
-        while len(results) < 10:
-            output = run_simulation(command)
+        # Every point uses the seeds 1, 2, ... until 10 valid results are collected, so the points
+        # are compared on the same scenarios and the cached runs are reused.
+        for seed in range(1, MAX_SEEDS + 1):
+            if len(results) == 10:
+                break
+
             try:
-                result_value = float(output[output_index].split(b": ")[1])
+                output = cache.run(command, seed)
+            except subprocess.CalledProcessError:
+                continue
+
+            try:
+                if output_prefix is not None:
+                    line = next(l for l in output if l.startswith(output_prefix.encode()))
+                    result_value = float(line.split(b":", 1)[1])
+                else:
+                    result_value = float(output[output_index].split(b": ")[1])
                 if filename == "time-benchmark.json" and result_value == 0.0:
                     continue
 
@@ -113,16 +263,20 @@ def run_benchmark(
             except Exception:
                 continue
 
+        if not results:
+            print(f"{benchmark_name}: {value}, No valid result")
+            continue
+
         average_result = sum(results) / len(results)
         benchmarks[value] = average_result
         print(f"{benchmark_name}: {value}, Avg result: {average_result}")
-        save_benchmarks(filename, benchmarks)
+        save_benchmarks(output_file, benchmarks)
 
     if plot:
-        plot_benchmarks(filename)
+        plot_benchmarks(output_file, protocol)
 
 
-def benchmark_time(plot: bool = False) -> None:
+def benchmark_time(plot: bool = False, protocol: str = "lr") -> None:
     """
     Benchmark the simulation time for different numbers of nodes.
     """
@@ -137,26 +291,35 @@ def benchmark_time(plot: bool = False) -> None:
         filename="time-benchmark.json",
         benchmark_name="Nodes",
         plot=plot,
+        # Measured by the applications, so every protocol is timed in the same way.
+        output_prefix="Mean delivery time",
+        protocol=protocol,
     )
 
 
-def benchmark_failure_rate_speed(plot: bool = False) -> None:
+def benchmark_failure_rate_speed(
+    plot: bool = False, predictive: bool = False, protocol: str = "lr"
+) -> None:
     """
-    Benchmark the failure rate for different speeds.
+    Benchmark the failure rate for different speeds, optionally with the predictive reversal.
     """
     command_template = "lra-simulator --range=30 --nodes=30 --speed={value}"
+    if predictive:
+        command_template += " --predictive"
+
     parameter_values = [2**i for i in range(0, 12)]
     run_benchmark(
         command_template,
         parameter_values,
         output_index=-1,
-        filename="speed-benchmark.json",
+        filename="speed-predictive-benchmark.json" if predictive else "speed-benchmark.json",
         benchmark_name="Speed",
         plot=plot,
+        protocol=protocol,
     )
 
 
-def benchmark_failure_rate_nodes(plot: bool = False) -> None:
+def benchmark_failure_rate_nodes(plot: bool = False, protocol: str = "lr") -> None:
     """
     Benchmark the failure rate for different numbers of nodes.
     """
@@ -169,16 +332,158 @@ def benchmark_failure_rate_nodes(plot: bool = False) -> None:
         filename="nodes-benchmark.json",
         benchmark_name="Nodes",
         plot=plot,
+        protocol=protocol,
     )
 
 
+def benchmark_startup(plot: bool = False, protocol: str = "lr") -> None:
+    """
+    Benchmark the wall-clock time to the first event for different numbers of nodes.
+    """
+    command_template = (
+        "lra-simulator --timing --fast-setup --duration=1 --packets=1 --nodes={value}"
+    )
+    parameter_values = [2**i for i in range(1, 17)] + [100000]
+    run_benchmark(
+        command_template,
+        parameter_values,
+        output_index=-1,
+        filename="startup-benchmark.json",
+        benchmark_name="Nodes",
+        plot=plot,
+        output_prefix="Time to first event",
+        protocol=protocol,
+    )
+
+
+def benchmark_memory(plot: bool = False, slim: bool = False, protocol: str = "lr") -> None:
+    """
+    Benchmark the resident memory per node for different numbers of nodes.
+
+    The slim benchmark also runs the default nodes, from the cache when they were already
+    measured, and prints the bytes per node saved at every network size.
+    """
+    command_template = (
+        "lra-simulator --memory-report --duration=1 --packets=1 --nodes={value}"
+    )
+
+    # The default nodes are always measured, from the cache when they already were, so the slim
+    # benchmark can compare with them.
+    parameter_values = [2**i for i in range(4, 17)]
+    run_benchmark(
+        command_template,
+        parameter_values,
+        output_index=-1,
+        filename="memory-benchmark.json",
+        benchmark_name="Nodes",
+        plot=plot and not slim,
+        output_prefix="Bytes per node",
+        protocol=protocol,
+    )
+
+    if not slim:
+        return
+
+    run_benchmark(
+        command_template + " --slim",
+        parameter_values,
+        output_index=-1,
+        filename="memory-slim-benchmark.json",
+        benchmark_name="Nodes",
+        plot=plot,
+        output_prefix="Bytes per node",
+        protocol=protocol,
+    )
+
+    if not os.path.exists("memory-benchmark.json") or not os.path.exists(
+        "memory-slim-benchmark.json"
+    ):
+        print("No valid result to compare")
+        return
+
+    with open("memory-benchmark.json") as f:
+        default = json.loads(f.read())
+    with open("memory-slim-benchmark.json") as f:
+        reduced = json.loads(f.read())
+
+    for nodes in sorted(set(default) & set(reduced), key=int):
+        saved = default[nodes] - reduced[nodes]
+        print(
+            f"Nodes: {nodes}, Saved per node: {saved:.0f} bytes "
+            f"({100 * saved / default[nodes]:.1f}%)"
+        )
+
+
+def benchmark_protocols() -> None:
+    """
+    Compare the routing protocols on the same scenario, seeds and traffic.
+    """
+    command_template = (
+        "lra-simulator --range=30 --nodes=30 --speed=1.5 --protocol={protocol}"
+    )
+    metrics = [
+        "Delivery ratio",
+        "Delivery time p50",
+        "Delivery time p95",
+        "Delivery time p99",
+        "Control packets",
+        "Control bytes",
+        "Wall-clock time",
+    ]
+    benchmarks = {}
+
+    for protocol in ["lr", "aodv", "olsr", "dsdv"]:
+        results = {metric: [] for metric in metrics}
+
+        for run in range(1, 11):
+            output = cache.run(command_template.format(protocol=protocol), run)
+            for metric in metrics:
+                line = next((l for l in output if l.startswith(metric.encode())), None)
+                # Link reversal prints n/a for the overhead it does not measure.
+                try:
+                    results[metric].append(float(line.split(b":", 1)[1]))
+                except (AttributeError, ValueError):
+                    continue
+
+        benchmarks[protocol] = {
+            metric: sum(values) / len(values) for metric, values in results.items() if values
+        }
+        print(f"Protocol: {protocol}, Avg results: {benchmarks[protocol]}")
+        save_benchmarks("protocols-benchmark.json", benchmarks)
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description="Run benchmarks for lra-simulator.")
     parser.add_argument(
         "benchmark",
-        choices=["time", "failure_rate_speed", "failure_rate_nodes"],
+        choices=[
+            "time",
+            "failure_rate_speed",
+            "failure_rate_speed_predictive",
+            "failure_rate_nodes",
+            "startup",
+            "memory",
+            "memory_slim",
+            "protocols",
+        ],
         help="Select the benchmark to run.",
     )
+    parser.add_argument(
+        "--protocol",
+        choices=["lr", "aodv", "olsr", "dsdv"],
+        default="lr",
+        help="Routing protocol used by the simulator.",
+    )
+    parser.add_argument(
+        "--cache",
+        default="benchmark-cache.jsonl",
+        help="Append-only file where the output of every run is cached.",
+    )
+    parser.add_argument(
+        "--no-cache",
+        action="store_true",
+        help="Run every simulation again, without reading or writing the cache.",
+    )
     parser.add_argument(
         "--plot",
         action="store_true",
@@ -186,9 +491,29 @@ if __name__ == "__main__":
     )
     args = parser.parse_args()
 
+    # The prediction only changes the link reversal routing.
+    if args.benchmark == "failure_rate_speed_predictive" and args.protocol != "lr":
+        parser.error("the predictive benchmark only supports --protocol=lr")
+
+    # The slim nodes are a reduced link reversal setup.
+    if args.benchmark == "memory_slim" and args.protocol != "lr":
+        parser.error("the slim benchmark only supports --protocol=lr")
+
+    cache = ResultCache(None if args.no_cache else args.cache)
+
     if args.benchmark == "time":
-        benchmark_time(plot=args.plot)
+        benchmark_time(plot=args.plot, protocol=args.protocol)
     elif args.benchmark == "failure_rate_speed":
-        benchmark_failure_rate_speed(plot=args.plot)
+        benchmark_failure_rate_speed(plot=args.plot, protocol=args.protocol)
+    elif args.benchmark == "failure_rate_speed_predictive":
+        benchmark_failure_rate_speed(plot=args.plot, predictive=True)
     elif args.benchmark == "failure_rate_nodes":
-        benchmark_failure_rate_nodes(plot=args.plot)
+        benchmark_failure_rate_nodes(plot=args.plot, protocol=args.protocol)
+    elif args.benchmark == "startup":
+        benchmark_startup(plot=args.plot, protocol=args.protocol)
+    elif args.benchmark == "memory":
+        benchmark_memory(plot=args.plot, protocol=args.protocol)
+    elif args.benchmark == "memory_slim":
+        benchmark_memory(plot=args.plot, slim=True, protocol=args.protocol)
+    elif args.benchmark == "protocols":
+        benchmark_protocols()
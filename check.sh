@@ -0,0 +1,15 @@
+#!/bin/sh
+#
+# Builds and links every executable of the simulation, runs the unit checks and a short simulation,
+# so a missing definition, a broken target or a regression of the helpers is caught before the
+# benchmarks. Run it from the scratch folder, next to lra-simulator.cc.
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+./ns3 build lra-simulator lra-sweep lr-engine-walk lra-check
+./ns3 run lra-check
+./ns3 run "lra-simulator --nodes=4 --duration=5 --packets=2"
+./ns3 run "lra-simulator --nodes=4 --duration=5 --packets=2 --fast-setup"
+./ns3 run 'lra-sweep --args="--nodes=4 --packets=2" --param=duration --values=5 --metrics=Success'
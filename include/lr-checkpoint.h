@@ -0,0 +1,124 @@
+#ifndef LR_CHECKPOINT_H
+#define LR_CHECKPOINT_H
+
+#include "lr-node-container.h"
+
+#include "ns3/core-module.h"
+#include "ns3/vector.h"
+
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrCheckpoint
+ * @brief Snapshot of the state of the nodes, used to warm-start a simulation.
+ *
+ * The checkpoint stores the height, position and velocity of every node, the IDs of the sinks and
+ * of the source and the seed and run number of the ns-3 random number generator, in a compact
+ * binary file. ns-3 does not expose the internal state of its random streams, so a restored
+ * simulation keeps the seed of the checkpoint but draws new values from the streams of its own
+ * run number.
+ */
+class LrCheckpoint
+{
+  public:
+    /**
+     * @brief State of a single node.
+     */
+    struct NodeState
+    {
+        double height;   //!< Height of the node.
+        Vector position; //!< Position of the node.
+        Vector velocity; //!< Velocity of the node.
+    };
+
+    /**
+     * @brief Captures the current state of the nodes and the sinks of the container.
+     *
+     * @param nodes The container holding the nodes of the simulation.
+     * @param sourceId The ID of the source node.
+     */
+    void Capture(LrNodeContainer& nodes, uint32_t sourceId);
+
+    /**
+     * @brief Writes the checkpoint to a binary file.
+     *
+     * @param filename The path of the file to write.
+     * @return True if the file was written, false otherwise.
+     */
+    bool Save(const std::string& filename) const;
+
+    /**
+     * @brief Reads a checkpoint from a binary file written by Save.
+     *
+     * @param filename The path of the file to read.
+     * @return True if the file is a valid checkpoint, false otherwise.
+     */
+    bool Load(const std::string& filename);
+
+    /**
+     * @brief Restores the heights and positions of the nodes.
+     *
+     * The velocities are only restored on nodes with a ConstantVelocityMobilityModel, the random
+     * walk draws a new direction as soon as its position is changed.
+     *
+     * @param nodes The container holding the nodes, which must be as many as in the checkpoint.
+     */
+    void Apply(LrNodeContainer& nodes) const;
+
+    /**
+     * @brief Returns the number of nodes in the checkpoint.
+     * @return uint32_t The number of nodes.
+     */
+    uint32_t GetN() const;
+
+    /**
+     * @brief Returns the IDs of the sink nodes of the checkpointed simulation.
+     * @return The sinks, the sink the packets are addressed to first.
+     */
+    const std::vector<uint32_t>& GetSinkIds() const;
+
+    /**
+     * @brief Returns the ID of the source node of the checkpointed simulation.
+     * @return uint32_t The ID of the source.
+     */
+    uint32_t GetSourceId() const;
+
+    /**
+     * @brief Returns the seed of the random number generator of the checkpointed simulation.
+     *
+     * The seed must be restored before the random variables of the simulation are created.
+     *
+     * @return uint32_t The seed.
+     */
+    uint32_t GetSeed() const;
+
+    /**
+     * @brief Returns the run number of the random number generator of the checkpointed
+     * simulation.
+     *
+     * A restored simulation that uses another run number draws different random values from the
+     * point of the checkpoint on.
+     *
+     * @return uint64_t The run number.
+     */
+    uint64_t GetRun() const;
+
+    /**
+     * @brief Returns the simulation time at which the checkpoint was captured.
+     * @return Time The capture time.
+     */
+    Time GetTime() const;
+
+  private:
+    std::vector<uint32_t> m_sinkIds;
+    uint32_t m_sourceId = 0;
+    uint32_t m_seed = 0;
+    uint64_t m_run = 0;
+    double m_time = 0;
+    std::vector<NodeState> m_nodes;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef LR_CHURN_INJECTOR_H
+#define LR_CHURN_INJECTOR_H
+
+#include "lr-node-container.h"
+
+#include "ns3/core-module.h"
+#include "ns3/nstime.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrChurnInjector
+ * @brief Crashes and rejoins nodes during the simulation and measures how the routing recovers.
+ *
+ * Failures are either scheduled for given nodes and times or drawn at random as a Poisson process
+ * over the nodes still running. A crashed node turns off its wifi PHYs, sets its IPv4 interfaces
+ * down and is marked inactive, so LrNodeContainer no longer reports it as anyone's neighbour.
+ * When its downtime expires the node rejoins with the height it had before the crash.
+ *
+ * A failure disrupts the flows that lose a packet after it. Its recovery ends with the first
+ * packet of one of those flows delivered to a sink, so a crash off the paths in use, which
+ * disrupts no flow, is never counted as recovered. The injector reports how long the recovery
+ * took and how many reversals were performed in the meantime. The sinks never fail.
+ */
+class LrChurnInjector
+{
+  public:
+    /**
+     * @brief Schedules failures from a comma-separated list of ID:T[:D] entries.
+     *
+     * Node ID crashes T seconds after the start of the simulation and rejoins D seconds later.
+     * Without D the node never rejoins.
+     *
+     * @param spec The list of failures.
+     * @return False if the list is malformed, in which case no failure is scheduled.
+     */
+    bool AddFailures(const std::string& spec);
+
+    /**
+     * @brief Sets the random failures.
+     *
+     * @param rate The mean number of failures per second over the whole network, 0 to disable.
+     * @param downtime The time a failed node waits before rejoining, 0 to never rejoin.
+     */
+    void SetChurn(double rate, Time downtime);
+
+    /**
+     * @brief Checks that no scheduled failure targets an unknown node or a sink.
+     *
+     * @param n The number of nodes.
+     * @param sinkIds The indexes of the sink nodes.
+     * @return True if every scheduled failure is valid.
+     */
+    bool Validate(uint32_t n, const std::vector<uint32_t>& sinkIds) const;
+
+    /**
+     * @brief Checks whether any failure is scheduled or drawn at random.
+     * @return True if the injector has something to do.
+     */
+    bool IsEnabled() const;
+
+    /**
+     * @brief Schedules the failures, which never pick the sinks of the container.
+     *
+     * @param nodes The container holding the nodes of the simulation.
+     */
+    void Start(LrNodeContainer* nodes);
+
+    /**
+     * @brief Marks a flow as disrupted by every failure whose recovery is in progress.
+     *
+     * Called for every packet dropped by the routing protocol.
+     *
+     * @param flow The ID of the source node of the packet.
+     */
+    void RecordFailure(uint32_t flow);
+
+    /**
+     * @brief Ends the recovery of every failure that disrupted a flow.
+     *
+     * Called for every packet received by a sink.
+     *
+     * @param flow The ID of the source node of the packet.
+     */
+    void RecordDelivery(uint32_t flow);
+
+    /**
+     * @brief Prints the failures, the rejoins and the recovery statistics.
+     */
+    void Report() const;
+
+  private:
+    /**
+     * @brief A failure given on the command line.
+     */
+    struct Failure
+    {
+        uint32_t nodeId; //!< Index of the node.
+        Time at;         //!< Time of the crash.
+        Time downtime;   //!< Time before the node rejoins, zero if it never does.
+    };
+
+    /**
+     * @brief A failure whose recovery is still in progress.
+     */
+    struct Recovery
+    {
+        Time failed;              //!< Time of the crash.
+        uint64_t reversals;       //!< Reversals performed by the container at the crash.
+        std::set<uint32_t> flows; //!< Flows that lost a packet since the crash.
+    };
+
+    /**
+     * @brief Crashes a node, unless it is already down.
+     *
+     * @param nodeId The index of the node.
+     * @param downtime The time before the node rejoins, zero if it never does.
+     */
+    void Fail(uint32_t nodeId, Time downtime);
+
+    /**
+     * @brief Brings a crashed node back.
+     *
+     * @param nodeId The index of the node.
+     */
+    void Rejoin(uint32_t nodeId);
+
+    /**
+     * @brief Turns the wifi PHYs and the IPv4 interfaces of a node off or on.
+     *
+     * @param node The node.
+     * @param up True to turn them on.
+     */
+    static void SetDevicesUp(Ptr<LrNode> node, bool up);
+
+    /**
+     * @brief Crashes a random running node and schedules the next random failure.
+     */
+    void DoChurn();
+
+    LrNodeContainer* m_nodes = nullptr;
+
+    std::vector<Failure> m_scheduled;
+    double m_rate = 0;
+    Time m_downtime;
+    Ptr<ExponentialRandomVariable> m_interArrival;
+    Ptr<UniformRandomVariable> m_choice;
+
+    uint32_t m_failures = 0;
+    uint32_t m_rejoins = 0;
+    std::vector<Recovery> m_pending;
+    std::vector<double> m_recoveryTimes;
+    std::vector<uint64_t> m_recoveryReversals;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef LR_DAG_MONITOR_H
+#define LR_DAG_MONITOR_H
+
+#include "lr-node-container.h"
+
+#include "ns3/core-module.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrDagMonitor
+ * @brief Periodically checks whether the height-induced graph is a destination-oriented DAG.
+ *
+ * At every sample the monitor takes a snapshot of the neighbourhood graph from the
+ * LrNodeContainer and runs a reverse BFS from the sinks, following only edges that go downhill
+ * towards them. A node can reach a sink when it is visited by this BFS; the DAG is converged when
+ * every node connected to a sink can reach one.
+ *
+ * Whenever the topology changes and the DAG is no longer converged, the monitor measures how long
+ * it takes for the heights to reach a stable configuration again.
+ */
+class LrDagMonitor
+{
+  public:
+    /**
+     * @brief A single observation of the DAG state.
+     */
+    struct Sample
+    {
+        Time time;                //!< Simulation time of the sample.
+        uint32_t connected;       //!< Nodes connected to the sink, sink excluded.
+        uint32_t reachable;       //!< Nodes with a downhill path to the sink, sink excluded.
+        bool topologyChanged;     //!< Whether the neighbourhood graph changed since the last sample.
+    };
+
+    /**
+     * @brief Starts sampling the DAG.
+     *
+     * The first sample is taken immediately, the following ones every `interval`.
+     *
+     * @param nodes The container holding the nodes of the simulation.
+     * @param interval The time between two samples.
+     */
+    void Start(LrNodeContainer* nodes, Time interval);
+
+    /**
+     * @brief Prints the convergence statistics collected so far.
+     */
+    void Report() const;
+
+    /**
+     * @brief Writes every sample to a CSV file.
+     *
+     * @param filename The path of the file to write.
+     */
+    void WriteSamples(const std::string& filename) const;
+
+  private:
+    /**
+     * @brief Takes a sample and schedules the next one.
+     */
+    void DoSample();
+
+    LrNodeContainer* m_nodes = nullptr;
+    Time m_interval;
+
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_columns;
+
+    std::vector<Sample> m_samples;
+
+    bool m_pending = false;
+    Time m_changeTime;
+    uint32_t m_topologyChanges = 0;
+    std::vector<Time> m_convergenceTimes;
+};
+
+#endif
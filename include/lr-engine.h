@@ -0,0 +1,332 @@
+#ifndef LR_ENGINE_H
+#define LR_ENGINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * \class LrEngine
+ * @brief Link reversal on plain arrays of positions and heights, without any ns-3 object.
+ *
+ * The static functions hold the parts of the algorithm shared with LrNodeContainer: the
+ * grid-bucketed neighbourhood graph, the height assigned by a reversal and the partition of a
+ * row of the graph into outbound and inbound neighbours. LrNodeContainer extracts the positions
+ * and heights of its nodes and delegates to them.
+ *
+ * An LrEngine instance owns a fixed neighbourhood graph in compressed sparse row form, with the
+ * outbound neighbours of every node before the inbound ones, and walks packets over it with the
+ * same rules as LinkReversalRouting and the distance next hop policy. Nodes are identified by
+ * their index in the arrays.
+ */
+class LrEngine
+{
+  public:
+    static constexpr uint32_t NO_NODE = UINT32_MAX; //!< Index returned when there is no node.
+
+    /**
+     * @brief Builds the undirected neighbourhood graph in compressed sparse row form.
+     *
+     * Nodes are bucketed into square cells of side `cellSize`, and `linked` is only called on
+     * the pairs of nodes in the same or in adjacent cells, so no link can be longer than the
+     * cell size. The neighbours of node i are stored in columns[offsets[i]] ...
+     * columns[offsets[i + 1] - 1].
+     *
+     * @param x The x coordinate of every node.
+     * @param y The y coordinate of every node.
+     * @param cellSize The side of the cells of the grid.
+     * @param linked Called as linked(i, j, distance), returns whether i and j are neighbours.
+     * @param offsets Output vector of x.size() + 1 row offsets.
+     * @param columns Output vector of neighbour indexes.
+     */
+    template <typename Linked>
+    static void BuildAdjacency(const std::vector<double>& x,
+                               const std::vector<double>& y,
+                               double cellSize,
+                               Linked linked,
+                               std::vector<uint32_t>& offsets,
+                               std::vector<uint32_t>& columns)
+    {
+        uint32_t n = x.size();
+        std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+        auto cellKey = [](int64_t cx, int64_t cy) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+                   static_cast<uint32_t>(cy);
+        };
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            cells[cellKey(std::floor(x[i] / cellSize), std::floor(y[i] / cellSize))].push_back(i);
+        }
+
+        offsets.assign(n + 1, 0);
+        columns.clear();
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            int64_t cx = std::floor(x[i] / cellSize);
+            int64_t cy = std::floor(y[i] / cellSize);
+
+            for (int64_t dx = -1; dx <= 1; dx++)
+            {
+                for (int64_t dy = -1; dy <= 1; dy++)
+                {
+                    auto cell = cells.find(cellKey(cx + dx, cy + dy));
+                    if (cell == cells.end())
+                        continue;
+
+                    for (uint32_t j : cell->second)
+                    {
+                        if (j == i)
+                            continue;
+
+                        double distance = std::hypot(x[i] - x[j], y[i] - y[j]);
+                        if (linked(i, j, distance))
+                            columns.push_back(j);
+                    }
+                }
+            }
+
+            offsets[i + 1] = columns.size();
+        }
+    }
+
+    /**
+     * @brief Computes the height of a node after the reversal of its links.
+     *
+     * The node is moved just above its highest inbound neighbour. If that neighbour has inbound
+     * neighbours of its own, the node is placed halfway between it and the lowest of them, so
+     * the order of the other heights is preserved.
+     *
+     * @param maxInbound The height of the highest inbound neighbour.
+     * @param hasAbove Whether the highest inbound neighbour has inbound neighbours.
+     * @param minAbove The height of the lowest inbound neighbour of the highest inbound
+     *                 neighbour, ignored if `hasAbove` is false.
+     * @return double The new height of the node.
+     */
+    static double GetReversedHeight(double maxInbound, bool hasAbove, double minAbove)
+    {
+        if (!hasAbove)
+            return maxInbound + 0.1;
+
+        return maxInbound + (minAbove - maxInbound) / 2;
+    }
+
+    /**
+     * @brief Moves the outbound neighbours of a node before its inbound ones.
+     *
+     * @param heights The height of every node.
+     * @param offsets The row offsets of the graph.
+     * @param columns The neighbour indexes of the graph, reordered in place.
+     * @param row The index of the node whose row is partitioned.
+     * @return uint32_t The index of the first inbound neighbour in `columns`.
+     */
+    static uint32_t PartitionRow(const std::vector<double>& heights,
+                                 const std::vector<uint32_t>& offsets,
+                                 std::vector<uint32_t>& columns,
+                                 uint32_t row)
+    {
+        double height = heights[row];
+
+        auto begin = columns.begin() + offsets[row];
+        auto end = columns.begin() + offsets[row + 1];
+        auto split = std::partition(begin, end, [&heights, height](uint32_t j) {
+            return heights[j] <= height;
+        });
+
+        return split - columns.begin();
+    }
+
+    /**
+     * @brief Builds the engine over a fixed set of nodes.
+     *
+     * @param x The x coordinate of every node.
+     * @param y The y coordinate of every node.
+     * @param heights The initial height of every node.
+     * @param range The communication range.
+     */
+    LrEngine(std::vector<double> x,
+             std::vector<double> y,
+             std::vector<double> heights,
+             double range)
+        : m_x(std::move(x)),
+          m_y(std::move(y)),
+          m_heights(std::move(heights))
+    {
+        BuildAdjacency(
+            m_x,
+            m_y,
+            range,
+            [range](uint32_t, uint32_t, double distance) { return distance <= range; },
+            m_offsets,
+            m_columns);
+
+        m_outboundEnd.resize(GetN());
+        for (uint32_t i = 0; i < GetN(); i++)
+        {
+            m_outboundEnd[i] = PartitionRow(m_heights, m_offsets, m_columns, i);
+        }
+    }
+
+    /**
+     * @brief Returns the number of nodes.
+     * @return uint32_t The number of nodes.
+     */
+    uint32_t GetN() const
+    {
+        return m_heights.size();
+    }
+
+    /**
+     * @brief Returns the number of directed edges of the neighbourhood graph.
+     * @return uint64_t The number of edges, every link is counted twice.
+     */
+    uint64_t GetEdges() const
+    {
+        return m_columns.size();
+    }
+
+    /**
+     * @brief Returns the height of a node.
+     * @param i The index of the node.
+     * @return double The height of the node.
+     */
+    double GetHeight(uint32_t i) const
+    {
+        return m_heights[i];
+    }
+
+    /**
+     * @brief Returns the number of reversals performed.
+     * @return uint64_t The number of reversals.
+     */
+    uint64_t GetReversals() const
+    {
+        return m_reversals;
+    }
+
+    /**
+     * @brief Reverses the links of a node, with the same rule as LrNodeContainer::ReverseLink.
+     *
+     * @param i The index of the node.
+     * @return True if the node had inbound neighbours and its height changed.
+     */
+    bool Reverse(uint32_t i)
+    {
+        uint32_t highest = NO_NODE;
+        for (uint32_t k = m_outboundEnd[i]; k < m_offsets[i + 1]; k++)
+        {
+            if (highest == NO_NODE || m_heights[m_columns[k]] > m_heights[highest])
+                highest = m_columns[k];
+        }
+
+        if (highest == NO_NODE)
+            return false;
+
+        uint32_t lowestAbove = NO_NODE;
+        for (uint32_t k = m_outboundEnd[highest]; k < m_offsets[highest + 1]; k++)
+        {
+            if (lowestAbove == NO_NODE || m_heights[m_columns[k]] < m_heights[lowestAbove])
+                lowestAbove = m_columns[k];
+        }
+
+        m_heights[i] = GetReversedHeight(m_heights[highest],
+                                         lowestAbove != NO_NODE,
+                                         lowestAbove != NO_NODE ? m_heights[lowestAbove] : 0);
+        m_reversals++;
+
+        m_outboundEnd[i] = PartitionRow(m_heights, m_offsets, m_columns, i);
+        for (uint32_t k = m_offsets[i]; k < m_offsets[i + 1]; k++)
+        {
+            uint32_t j = m_columns[k];
+            m_outboundEnd[j] = PartitionRow(m_heights, m_offsets, m_columns, j);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Chooses the outbound neighbour closest to the destination.
+     *
+     * @param i The index of the node holding the packet.
+     * @param previous The index of the previous hop, which is never chosen.
+     * @param destination The index of the destination.
+     * @return uint32_t The index of the next hop, or NO_NODE if there is none.
+     */
+    uint32_t GetNextHop(uint32_t i, uint32_t previous, uint32_t destination) const
+    {
+        uint32_t nextHop = NO_NODE;
+        double bestDistance = 0;
+
+        for (uint32_t k = m_offsets[i]; k < m_outboundEnd[i]; k++)
+        {
+            uint32_t j = m_columns[k];
+            if (j == previous)
+                continue;
+
+            if (j == destination)
+                return j;
+
+            double distance = std::hypot(m_x[j] - m_x[destination], m_y[j] - m_y[destination]);
+            if (nextHop == NO_NODE || distance < bestDistance)
+            {
+                nextHop = j;
+                bestDistance = distance;
+            }
+        }
+
+        return nextHop;
+    }
+
+    /**
+     * @brief Walks a packet from a source to a destination.
+     *
+     * At every hop a node without outbound neighbours reverses its links once, as in
+     * LinkReversalRouting, and the packet is dropped if it still has no next hop or if it
+     * exceeds the TTL.
+     *
+     * @param source The index of the source.
+     * @param destination The index of the destination.
+     * @param ttl The maximum number of hops.
+     * @param hops Output number of hops taken by the packet.
+     * @return True if the packet reached the destination.
+     */
+    bool Walk(uint32_t source, uint32_t destination, uint32_t ttl, uint32_t& hops)
+    {
+        uint32_t previous = NO_NODE;
+        uint32_t current = source;
+
+        for (hops = 0; current != destination; hops++)
+        {
+            if (hops == ttl)
+                return false;
+
+            if (m_offsets[current] == m_outboundEnd[current])
+                Reverse(current);
+
+            uint32_t next = GetNextHop(current, previous, destination);
+            if (next == NO_NODE)
+                return false;
+
+            previous = current;
+            current = next;
+        }
+
+        return true;
+    }
+
+  private:
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_heights;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_columns;
+    std::vector<uint32_t> m_outboundEnd;
+    uint64_t m_reversals = 0;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef LR_FAILURE_STATS_H
+#define LR_FAILURE_STATS_H
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrFailureStats
+ * @brief Counts the delivery failures by cause and by the node where they happened.
+ *
+ * The routing failures are recorded by LinkReversalRouting, the packets dropped by the wifi MAC
+ * and the frames lost by the wifi PHY are recorded from the drop traces of the devices once
+ * Start is called. Only the MAC drops of data packets are failures, the routing messages the
+ * MAC gives up on are not. The PHY losses are frames, which the MAC may still retransmit
+ * successfully, so they are reported apart and do not count towards the hotspots.
+ */
+class LrFailureStats
+{
+  public:
+    /**
+     * @brief Reason why a packet was not delivered.
+     */
+    enum Cause
+    {
+        NO_ROUTE_OUTPUT, //!< No next hop at the source.
+        NO_ROUTE_INPUT,  //!< No next hop at a forwarding node.
+        TTL_EXPIRED,     //!< The TTL expired before reaching the destination.
+        PARTITIONED,     //!< The node was cut off from the destination.
+        MAC_RETRY_LIMIT, //!< The MAC reached the retry limit.
+        MAC_QUEUE,       //!< The MAC queue was full.
+        MAC_LIFETIME,    //!< The packet waited in the MAC queue for too long.
+        MAC_OTHER,       //!< The MAC dropped the packet for any other reason.
+        CAUSES           //!< Number of causes.
+    };
+
+    /**
+     * @brief Connects the counters to the MAC and PHY drop traces of every wifi device.
+     *
+     * @param dataPort The UDP port of the data packets, the MAC drops of any other packet, such
+     * as the routing messages, are not failures.
+     */
+    void Start(uint16_t dataPort);
+
+    /**
+     * @brief Records a failure.
+     *
+     * @param nodeId The ID of the node where the packet was lost.
+     * @param cause The reason of the failure.
+     */
+    void RecordFailure(uint32_t nodeId, Cause cause);
+
+    /**
+     * @brief Returns the number of failures recorded for a cause.
+     *
+     * @param cause The cause.
+     * @return uint64_t The number of failures.
+     */
+    uint64_t GetFailures(Cause cause) const;
+
+    /**
+     * @brief Returns the number of packets dropped by the wifi MAC, for every MAC cause.
+     *
+     * @return uint64_t The number of packets dropped by the MAC.
+     */
+    uint64_t GetMacDrops() const;
+
+    /**
+     * @brief Prints the failures by cause and the PHY frame losses.
+     */
+    void Report() const;
+
+    /**
+     * @brief Prints the nodes with the most failures and their breakdown by cause.
+     *
+     * @param count The number of nodes to print.
+     */
+    void ReportHotspots(uint32_t count) const;
+
+    /**
+     * @brief Returns the name of a cause, as printed in the reports.
+     *
+     * @param cause The cause.
+     * @return std::string The name of the cause.
+     */
+    static std::string GetCauseName(Cause cause);
+
+  private:
+    /**
+     * @brief Records a packet dropped by the wifi MAC.
+     *
+     * @param context The trace path, which contains the ID of the node.
+     * @param reason The reason of the drop.
+     * @param mpdu The dropped MPDU.
+     */
+    void MacDrop(std::string context, WifiMacDropReason reason, Ptr<const WifiMpdu> mpdu);
+
+    /**
+     * @brief Returns whether an MSDU is a UDP datagram addressed to the data port.
+     *
+     * @param msdu The MSDU, starting with its LLC/SNAP header.
+     * @return True if the MSDU is a data packet.
+     */
+    bool IsDataPacket(Ptr<const Packet> msdu) const;
+
+    /**
+     * @brief Records a unicast data frame that the wifi PHY of its receiver failed to decode.
+     *
+     * @param context The trace path, which contains the IDs of the node and of the device.
+     * @param packet The frame.
+     * @param reason The reason of the failure.
+     */
+    void PhyRxDrop(std::string context, Ptr<const Packet> packet, WifiPhyRxfailureReason reason);
+
+    uint16_t m_dataPort = 0;
+    std::array<uint64_t, CAUSES> m_causes = {};
+    std::vector<std::array<uint64_t, CAUSES>> m_nodes;
+    std::vector<uint64_t> m_phyLosses;
+};
+
+#endif
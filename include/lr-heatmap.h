@@ -0,0 +1,84 @@
+#ifndef LR_HEATMAP_H
+#define LR_HEATMAP_H
+
+#include "lr-node-container.h"
+
+#include "ns3/core-module.h"
+#include "ns3/nstime.h"
+
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrHeatmap
+ * @brief Bins the per-node forwarding load, reversals and sink-less time on a grid.
+ *
+ * The packets forwarded and the reversals are counted by the nodes themselves. The sink-less
+ * time is sampled by the heatmap: every interval the nodes that LrNodeContainer::IsSinkless
+ * reports are charged with the whole interval.
+ *
+ * At the end of the run the counters are summed over a square grid of bins covering the final
+ * positions of the nodes, and written either as a CSV file or, when the file name ends in .pgm,
+ * as one greyscale image per counter.
+ */
+class LrHeatmap
+{
+  public:
+    /**
+     * @brief Starts sampling the sink-less time of the nodes.
+     *
+     * @param nodes The container holding the nodes of the simulation, whose sinks are never
+     * sink-less.
+     * @param interval The time between two samples.
+     */
+    void Start(LrNodeContainer* nodes, Time interval);
+
+    /**
+     * @brief Writes the heatmap.
+     *
+     * @param filename The path of the CSV file, or of the PGM images when it ends in .pgm, in
+     *                 which case the name of the counter is added before the extension.
+     * @param bins The number of bins on each side of the grid.
+     * @return True if every file was written.
+     */
+    bool Write(const std::string& filename, uint32_t bins) const;
+
+  private:
+    /**
+     * @brief Counters summed over the nodes of a bin.
+     */
+    struct Bin
+    {
+        uint32_t nodes = 0;     //!< Nodes whose final position falls in the bin.
+        uint64_t forwarded = 0; //!< Packets forwarded.
+        uint64_t reversals = 0; //!< Reversals performed.
+        double sinkless = 0;    //!< Seconds spent without outbound neighbours.
+    };
+
+    /**
+     * @brief Charges the sink-less nodes with the interval and schedules the next sample.
+     */
+    void DoSample();
+
+    /**
+     * @brief Writes one counter of the grid as a binary PGM image scaled to its maximum.
+     *
+     * @param filename The path of the image.
+     * @param bins The number of bins on each side of the grid.
+     * @param values The value of each bin, row by row.
+     * @return True if the image was written.
+     */
+    static bool WritePgm(const std::string& filename,
+                         uint32_t bins,
+                         const std::vector<double>& values);
+
+    LrNodeContainer* m_nodes = nullptr;
+    Time m_interval;
+
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_columns;
+};
+
+#endif
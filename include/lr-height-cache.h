@@ -0,0 +1,124 @@
+#ifndef LR_HEIGHT_CACHE_H
+#define LR_HEIGHT_CACHE_H
+
+#include "lr-height-tag.h"
+#include "lr-node.h"
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrHeightCache
+ * @brief Heights of the neighbours as learned by each node from the packets it overhears.
+ *
+ * Every packet forwarded by LinkReversalRouting carries an LrHeightTag with the height of the
+ * transmitter and the freshest heights it learned. Once Start is called, every frame sniffed by
+ * a wifi PHY updates the cache of the receiving node, whether the frame is addressed to it or
+ * not, so no control packet is ever sent.
+ *
+ * GetHeight answers the neighbour queries of LrNodeContainer with the learned height when it is
+ * younger than the staleness bound. A neighbour never heard, or not heard for longer than the
+ * bound, is unknown and LrNodeContainer leaves it out of both the inbound and the outbound
+ * neighbours. Every lookup is checked against the actual height: it is accurate when it puts the
+ * neighbour on the same side of the querying node, an unknown neighbour is never accurate.
+ */
+class LrHeightCache
+{
+  public:
+    /**
+     * @brief Connects the cache to the MonitorSnifferRx trace of every wifi PHY.
+     *
+     * @param staleness The age beyond which a learned height is no longer used.
+     */
+    void Start(Time staleness);
+
+    /**
+     * @brief Checks whether the cache has been started.
+     * @return True if the packets are tagged and the learned heights are used.
+     */
+    bool IsEnabled() const;
+
+    /**
+     * @brief Tags a packet with the height of its transmitter and the freshest heights it
+     * learned, replacing the tag of the previous hop.
+     *
+     * @param node The node transmitting the packet.
+     * @param packet The packet.
+     */
+    void TagPacket(Ptr<LrNode> node, Ptr<Packet> packet);
+
+    /**
+     * @brief Returns the height of a neighbour as known by a node.
+     *
+     * @param node The node querying the height.
+     * @param neighbour The neighbour.
+     * @param height Output height learned by the node, unchanged if it is unknown.
+     * @return True if the node learned the height less than the staleness bound ago.
+     */
+    bool GetHeight(Ptr<LrNode> node, Ptr<LrNode> neighbour, double& height);
+
+    /**
+     * @brief Records a height learned by a node, unless it already knows a fresher one.
+     *
+     * @param nodeId The ID of the node learning the height.
+     * @param neighbourId The ID of the node the height belongs to.
+     * @param height The height.
+     * @param time The time at which the neighbour carried this height.
+     */
+    void Learn(uint32_t nodeId, uint32_t neighbourId, double height, Time time);
+
+    /**
+     * @brief Prints the lookups, the share of unknown neighbours, the share answered from the
+     * cache, the accuracy over every lookup and the bytes piggybacked on the packets.
+     */
+    void Report() const;
+
+  private:
+    /**
+     * @brief A height learned by a node.
+     */
+    struct Learned
+    {
+        double height; //!< Height of the neighbour.
+        Time time;     //!< Time at which the neighbour carried this height.
+    };
+
+    /**
+     * @brief Learns the heights carried by a frame received by a wifi PHY.
+     *
+     * @param context The trace path, which contains the ID of the receiving node.
+     * @param packet The MPDU received.
+     * @param channelFreqMhz The frequency of the channel.
+     * @param txVector The transmission parameters.
+     * @param aMpdu The A-MPDU information.
+     * @param signalNoise The signal and noise power of the frame.
+     * @param staId The station ID.
+     */
+    void SnifferRx(std::string context,
+                   Ptr<const Packet> packet,
+                   uint16_t channelFreqMhz,
+                   WifiTxVector txVector,
+                   MpduInfo aMpdu,
+                   SignalNoiseDbm signalNoise,
+                   uint16_t staId);
+
+    bool m_enabled = false;
+    Time m_staleness;
+
+    std::vector<std::unordered_map<uint32_t, Learned>> m_learned;
+
+    uint64_t m_lookups = 0;
+    uint64_t m_unknown = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_accurate = 0;
+    uint64_t m_taggedPackets = 0;
+    uint64_t m_piggybackedBytes = 0;
+};
+
+#endif
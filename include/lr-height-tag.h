@@ -0,0 +1,63 @@
+#ifndef LR_HEIGHT_TAG_H
+#define LR_HEIGHT_TAG_H
+
+#include "ns3/tag.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrHeightTag
+ * @brief Packet tag carrying the height of the transmitter and some of the heights it learned.
+ *
+ * The first entry is always the transmitter itself with an age of zero. The other entries are
+ * heights the transmitter learned by overhearing its neighbours, with the time elapsed since they
+ * were carried by the neighbour, so a receiver can tell how stale they are.
+ */
+class LrHeightTag : public Tag
+{
+  public:
+    static constexpr uint8_t MAX_ENTRIES = 4; //!< Maximum number of heights in a tag.
+
+    /**
+     * @brief A height carried by the tag.
+     */
+    struct Entry
+    {
+        uint32_t nodeId; //!< ID of the node the height belongs to.
+        double height;   //!< Height of the node.
+        uint16_t ageMs;  //!< Age of the height in milliseconds, saturated.
+    };
+
+    /**
+     * @brief Get the type ID.
+     * @return The TypeId of the object.
+     */
+    static TypeId GetTypeId(void);
+
+    TypeId GetInstanceTypeId(void) const override;
+    uint32_t GetSerializedSize(void) const override;
+    void Serialize(TagBuffer buffer) const override;
+    void Deserialize(TagBuffer buffer) override;
+    void Print(std::ostream& os) const override;
+
+    /**
+     * @brief Adds a height to the tag, unless it is full.
+     *
+     * @param entry The height to add.
+     * @return False if the tag already holds MAX_ENTRIES heights.
+     */
+    bool AddEntry(const Entry& entry);
+
+    /**
+     * @brief Returns the heights carried by the tag.
+     * @return The entries, the transmitter first.
+     */
+    const std::vector<Entry>& GetEntries() const;
+
+  private:
+    std::vector<Entry> m_entries;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef LR_LINK_TABLE_H
+#define LR_LINK_TABLE_H
+
+#include "lr-node.h"
+
+#include "ns3/core-module.h"
+#include "ns3/mac48-address.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/wifi-module.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+using namespace ns3;
+
+/**
+ * \class LrLinkTable
+ * @brief Decides which nodes are neighbours from the signal strength measured by the radios.
+ *
+ * The table records the received signal strength of every frame sniffed by the wifi PHYs,
+ * smoothed with an exponential moving average, for each pair of nodes. Pairs that have not been
+ * heard recently fall back to the signal strength predicted by the propagation loss model of the
+ * channel, so nodes that never exchanged a frame can still be neighbours.
+ *
+ * A link comes up when its signal strength reaches the threshold and only goes down when it drops
+ * below the threshold minus the hysteresis, so links at the edge of the radio range do not flap.
+ * The state of a link only changes when one of its frames is measured, the predicted strength is
+ * compared against the last measured state without changing it. Links are symmetric: a frame
+ * heard in either direction updates the same entry.
+ */
+class LrLinkTable
+{
+  public:
+    /**
+     * @brief Sets the threshold and the hysteresis of the links.
+     *
+     * @param thresholdDbm The signal strength at which a link comes up, in dBm.
+     * @param hysteresisDb The margin below the threshold at which a link goes down, in dB.
+     */
+    void SetThreshold(double thresholdDbm, double hysteresisDb);
+
+    /**
+     * @brief Sets the model used to predict the signal strength of the links not heard recently.
+     *
+     * @param lossModel The propagation loss model of the channel.
+     * @param txPowerDbm The transmission power of the radios, in dBm.
+     */
+    void SetPrediction(Ptr<PropagationLossModel> lossModel, double txPowerDbm);
+
+    /**
+     * @brief Registers the MAC address of a wifi device, so its frames can be attributed to
+     * the node.
+     *
+     * @param nodeId The ID of the node owning the device.
+     * @param address The MAC address of the device.
+     */
+    void AddDevice(uint32_t nodeId, Mac48Address address);
+
+    /**
+     * @brief Connects the table to the MonitorSnifferRx trace of every wifi PHY.
+     */
+    void Start();
+
+    /**
+     * @brief Checks whether two nodes are neighbours.
+     *
+     * @param a The first node.
+     * @param b The second node.
+     * @return True if the link between the two nodes is up.
+     */
+    bool IsNeighbour(Ptr<LrNode> a, Ptr<LrNode> b) const;
+
+    /**
+     * @brief Returns the distance at which the predicted signal strength of an up link falls
+     * below the threshold minus the hysteresis.
+     *
+     * The loss model is assumed to grow with the distance, and the distance is found by
+     * bisection, so the result is meant to be computed once and cached.
+     *
+     * @param maxDistance The largest distance searched.
+     * @return double The break distance, or `maxDistance` without a loss model or when the links
+     *         do not break before it.
+     */
+    double GetBreakDistance(double maxDistance) const;
+
+    /**
+     * @brief Returns the number of link state changes.
+     * @return uint64_t The number of times a link came up or went down.
+     */
+    uint64_t GetTransitions() const;
+
+    /**
+     * @brief Returns the number of frames whose signal strength was recorded.
+     * @return uint64_t The number of measurements.
+     */
+    uint64_t GetMeasurements() const;
+
+  private:
+    /**
+     * @brief State of the link between two nodes.
+     */
+    struct Link
+    {
+        double rss = 0;        //!< Smoothed signal strength, in dBm.
+        Time heard;            //!< Time of the last measurement.
+        bool measured = false; //!< Whether the link has ever been measured.
+        bool up = false;       //!< Whether the link is up.
+    };
+
+    /**
+     * @brief Records the signal strength of a frame received by a wifi PHY.
+     *
+     * @param context The trace path, which contains the ID of the receiving node.
+     * @param packet The MPDU received.
+     * @param channelFreqMhz The frequency of the channel.
+     * @param txVector The transmission parameters.
+     * @param aMpdu The A-MPDU information.
+     * @param signalNoise The signal and noise power of the frame.
+     * @param staId The station ID.
+     */
+    void SnifferRx(std::string context,
+                   Ptr<const Packet> packet,
+                   uint16_t channelFreqMhz,
+                   WifiTxVector txVector,
+                   MpduInfo aMpdu,
+                   SignalNoiseDbm signalNoise,
+                   uint16_t staId);
+
+    /**
+     * @brief Applies the threshold and the hysteresis to a signal strength.
+     *
+     * @param link The link, whose current state selects the threshold.
+     * @param rss The signal strength, in dBm.
+     * @return True if the link is up at this signal strength.
+     */
+    bool IsUp(const Link& link, double rss) const;
+
+    /**
+     * @brief Returns the key of the link between two nodes.
+     *
+     * @param a The ID of the first node.
+     * @param b The ID of the second node.
+     * @return uint64_t The key, which does not depend on the order of the nodes.
+     */
+    static uint64_t GetKey(uint32_t a, uint32_t b);
+
+    double m_threshold = -73;
+    double m_hysteresis = 3;
+    double m_txPower = 16.0206;
+    Ptr<PropagationLossModel> m_lossModel;
+
+    std::map<Mac48Address, uint32_t> m_devices;
+    std::unordered_map<uint64_t, Link> m_links;
+
+    uint64_t m_transitions = 0;
+    uint64_t m_measurements = 0;
+};
+
+#endif
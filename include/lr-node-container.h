@@ -1,6 +1,8 @@
 #ifndef LR_NODE_CONTAINER_H
 #define LR_NODE_CONTAINER_H
 
+#include "lr-height-cache.h"
+#include "lr-link-table.h"
 #include "lr-node.h"
 
 #include "ns3/core-module.h"
@@ -9,7 +11,9 @@
 #include "ns3/object.h"
 #include "ns3/pointer.h"
 
-#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -27,6 +31,19 @@ using namespace ns3;
 class LrNodeContainer : public NodeContainer, public Object
 {
   public:
+    /**
+     * @brief Rule used by GetNextHop to choose among the outbound neighbours.
+     */
+    enum NextHopPolicy
+    {
+        DISTANCE,  //!< Closest to the destination.
+        HEIGHT,    //!< Lowest height.
+        HOPS,      //!< Fewest hops to the destination, as learned from the deliveries.
+        LIFETIME,  //!< Most forward progress, weighted by the link lifetime.
+        RANDOM,    //!< Uniformly random.
+        CONGESTION //!< Closest to the destination, penalized by the packets in its MAC queue.
+    };
+
     uint m_maxRange;
 
     /**
@@ -49,14 +66,55 @@ class LrNodeContainer : public NodeContainer, public Object
      * node.
      *
      * This method creates `n` nodes and assigns each a unique height. The node identified by
-     * `sinkID` is assigned a height of 0.0, indicating it is the sink node. The other nodes are
-     * assigned random heights, ensuring no two nodes have the same height.
+     * `sinkID` is assigned a height of 0.0, indicating it is the sink node. The other nodes take
+     * the slots of a random permutation of evenly spaced heights, so no two nodes have the same
+     * height and the assignment stays linear in `n`. The time spent in each phase is logged at
+     * the info level.
      *
      * @param n The number of nodes to be created.
      * @param sinkID The ID of the node that will act as the sink (assigned a height of 0.0).
      */
     void Create(uint32_t n, uint32_t sinkID);
 
+    /**
+     * @brief Creates a specified number of nodes with several sink nodes.
+     *
+     * Every sink is assigned a height of 0.0, so the heights form a DAG with one root per sink.
+     * GetNextHop treats the sinks as a group: a packet addressed to any of them is handed to the
+     * first sink among the outbound neighbours, and the distance to the destination is the
+     * distance to the closest sink.
+     *
+     * @param n The number of nodes to be created.
+     * @param sinkIDs The IDs of the sink nodes.
+     */
+    void Create(uint32_t n, const std::vector<uint32_t>& sinkIDs);
+
+    /**
+     * @brief Returns the wall-clock time the last Create spent drawing the unique heights.
+     * @return double The time in seconds.
+     */
+    double GetHeightAssignmentTime() const;
+
+    /**
+     * @brief Returns the wall-clock time the last Create spent creating the node objects.
+     * @return double The time in seconds.
+     */
+    double GetNodeCreationTime() const;
+
+    /**
+     * @brief Checks whether a node is one of the sinks.
+     *
+     * @param i The index of the node.
+     * @return True if the node was created as a sink.
+     */
+    bool IsSink(uint32_t i) const;
+
+    /**
+     * @brief Returns the indexes of the sink nodes.
+     * @return The sinks, in the order they were given to Create.
+     */
+    const std::vector<uint32_t>& GetSinks() const;
+
     /**
      * @brief Reverses the link of the given node by adjusting its height based on its inbound
      * neighbors.
@@ -68,6 +126,9 @@ class LrNodeContainer : public NodeContainer, public Object
      * If the maximum height node itself has inbound neighbors, the height of the given node is set
      * to mantain the order of heights.
      *
+     * With partition detection enabled, a node cut off from the sink is left unchanged and the
+     * skipped reversal is counted instead.
+     *
      * @param node The node for which the link is to be reversed.
      */
     void ReverseLink(Ptr<LrNode> node);
@@ -80,12 +141,38 @@ class LrNodeContainer : public NodeContainer, public Object
      */
     Ptr<LrNode> Get(int i);
 
+    /**
+     * @brief Registers an address assigned to one of the interfaces of a node.
+     *
+     * The registered addresses are used by GetNodeFromIPv4 and GetAddresses, so the routing
+     * protocol does not have to query the IPv4 stack of other nodes for every packet.
+     *
+     * @param node The node owning the address.
+     * @param address The address assigned to the node.
+     */
+    void AddAddress(Ptr<LrNode> node, Ipv4InterfaceAddress address);
+
+    /**
+     * @brief Unregisters an address previously registered with AddAddress.
+     *
+     * @param node The node owning the address.
+     * @param address The address removed from the node.
+     */
+    void RemoveAddress(Ptr<LrNode> node, Ipv4InterfaceAddress address);
+
+    /**
+     * @brief Retrieves the addresses registered for a node.
+     *
+     * @param node The node whose addresses are returned.
+     * @return The addresses of every interface of the node.
+     */
+    const std::vector<Ipv4InterfaceAddress>& GetAddresses(Ptr<LrNode> node);
+
     /**
      * @brief Retrieves a node based on its IPv4 address.
      *
-     * This method iterates through all nodes in the current container and returns the node whose
-     * IPv4 address matches the specified address. If no node is found with the given IPv4 address,
-     * it returns nullptr.
+     * This method looks up the address among the ones registered by the routing with AddAddress,
+     * in constant time. The any-address and the unregistered addresses return nullptr.
      *
      * @param address The IPv4 address of the node to be found.
      * @return Ptr<LrNode> The node with the matching IPv4 address, or nullptr if no such node is
@@ -93,12 +180,44 @@ class LrNodeContainer : public NodeContainer, public Object
      */
     Ptr<LrNode> GetNodeFromIPv4(Ipv4Address address);
 
+    /**
+     * @brief Decides the neighbours with a link table within the maximum range.
+     *
+     * Two nodes are neighbours when they are within the maximum range and the link table reports
+     * their link as up, so the neighbour queries and GetAdjacency, whose grid has cells as large
+     * as the maximum range, always agree.
+     *
+     * @param linkTable The link table, or nullptr to go back to the maximum range.
+     */
+    void SetLinkTable(LrLinkTable* linkTable);
+
+    /**
+     * @brief Reads the heights of the neighbours from a height cache instead of the nodes.
+     *
+     * Each node then sees its neighbours with the heights it learned from the packets it
+     * overheard, and the neighbours whose height is unknown or stale are neither inbound nor
+     * outbound. The sinks never reverse, so their height is always known. Every node starts with
+     * the current heights of its neighbours, as after an initial round of beacons. The static
+     * adjacency is no longer used since its rows are partitioned with the actual heights.
+     *
+     * @param heightCache The height cache, or nullptr to go back to the actual heights.
+     */
+    void SetHeightCache(LrHeightCache* heightCache);
+
+    /**
+     * @brief Sets the rule used by GetNextHop to choose among the outbound neighbours.
+     *
+     * @param policy The next hop policy, DISTANCE by default.
+     */
+    void SetNextHopPolicy(NextHopPolicy policy);
+
     /**
      * @brief Determines the next hop node for routing from the actual node to the destination.
      *
-     * This method retrieves the outbound neighbors of the actual node and attempts to find the best
-     * next hop node that brings the packet closer to the destination. It ensures that the next hop
-     * is not the source and attempts to directly reach the destination if possible.
+     * This method retrieves the outbound neighbors of the actual node, excluding the source, and
+     * returns the destination if it is among them. Otherwise the next hop is chosen by the
+     * configured NextHopPolicy. With the HOPS policy the candidates are ranked by the hop
+     * estimates learned by RecordDelivery.
      *
      * If no valid next hop is found, it returns nullptr.
      *
@@ -109,6 +228,35 @@ class LrNodeContainer : public NodeContainer, public Object
      */
     Ptr<LrNode> GetNextHop(Ptr<LrNode> actualNode, Ipv4Address source, Ipv4Address destination);
 
+    /**
+     * @brief Records that a node sent or forwarded a packet, with the HOPS policy.
+     *
+     * @param packetId The UID of the packet.
+     * @param node The node.
+     */
+    void RecordHop(uint64_t packetId, Ptr<LrNode> node);
+
+    /**
+     * @brief Learns the hop estimates from a packet delivered to a sink, with the HOPS policy.
+     *
+     * Every node on the path of the packet learns the number of hops the packet took from it to
+     * the sink. A node visited more than once keeps the hops from its last visit.
+     *
+     * @param packetId The UID of the packet.
+     */
+    void RecordDelivery(uint64_t packetId);
+
+    /**
+     * @brief Forgets the hop estimates of the nodes on the path of a lost packet, with the HOPS
+     * policy.
+     *
+     * The paths those estimates were learned on no longer deliver, so the nodes count as unknown
+     * until a delivery teaches them again.
+     *
+     * @param packetId The UID of the packet.
+     */
+    void RecordLoss(uint64_t packetId);
+
     /**
      * @brief Retrieves the neighboring nodes of a specified LrNode within a certain range and that
      * satisfy a specific filter condition.
@@ -154,8 +302,309 @@ class LrNodeContainer : public NodeContainer, public Object
      */
     Ptr<LrNodeContainer> GetOutBoundNeighbours(Ptr<LrNode> node);
 
+    /**
+     * @brief Checks whether a node has at least one outbound neighbour.
+     *
+     * With the static adjacency no container is built, so the routing can check every packet.
+     *
+     * @param node The node to check.
+     * @return True if GetOutBoundNeighbours would return a non-empty container.
+     */
+    bool HasOutBoundNeighbours(Ptr<LrNode> node);
+
+    /**
+     * @brief Builds a snapshot of the undirected neighbourhood graph in compressed sparse row
+     * form.
+     *
+     * Nodes are bucketed into square cells whose side is the maximum range, so only the
+     * surrounding cells have to be scanned for each node. The neighbours of the node at index i
+     * are stored in columns[offsets[i]] ... columns[offsets[i + 1] - 1], as container indexes.
+     *
+     * @param offsets Output vector of GetN() + 1 row offsets.
+     * @param columns Output vector of neighbour indexes.
+     */
+    void GetAdjacency(std::vector<uint32_t>& offsets, std::vector<uint32_t>& columns);
+
+    /**
+     * @brief Checks whether a node is sink-less on a snapshot of the neighbourhood graph.
+     *
+     * A node is sink-less when it has neighbours and all of them are higher than itself, so a
+     * reversal would give it an outbound link. The sinks are never sink-less, and neither are the
+     * isolated nodes, which have no link to reverse.
+     *
+     * @param i The index of the node.
+     * @param offsets The row offsets returned by GetAdjacency.
+     * @param columns The neighbour indexes returned by GetAdjacency.
+     * @return True if the node is sink-less.
+     */
+    bool IsSinkless(uint32_t i,
+                    const std::vector<uint32_t>& offsets,
+                    const std::vector<uint32_t>& columns);
+
+    /**
+     * @brief Reverses the links of the nodes that have no outbound neighbours.
+     *
+     * The sink-less nodes are found on a snapshot of the neighbourhood graph and kept in a work
+     * list: every time a node is reversed, its neighbours are checked again, since they may have
+     * lost their last outbound link. The sweep ends when no node apart from the sinks, which are
+     * never reversed, is left without outbound neighbours, or when `maxReversals` reversals have
+     * been performed, which bounds the work spent on components that are disconnected from them.
+     *
+     * @param maxReversals The maximum number of reversals performed by the sweep.
+     * @return uint32_t The number of reversals performed.
+     */
+    uint32_t ReverseSinklessNodes(uint32_t maxReversals);
+
+    /**
+     * @brief Returns the number of reversals that changed the height of a node.
+     * @return uint64_t The number of reversals performed so far.
+     */
+    uint64_t GetReversals() const;
+
+    /**
+     * @brief Enables the prediction of the link breaks from the velocities of the nodes.
+     *
+     * An outbound link is durable when both nodes are predicted to stay in range for at least
+     * `horizon`. GetNextHop then only chooses among the durable outbound neighbours, if there
+     * are any, and ReverseExpiringLinks reverses a node whose outbound links are all about to
+     * break, before the last of them goes.
+     *
+     * @param horizon The minimum predicted lifetime of a durable link.
+     */
+    void SetPrediction(Time horizon);
+
+    /**
+     * @brief Reverses the links of a node whose outbound links are all predicted to break
+     * within the prediction horizon.
+     *
+     * Nothing is done when the prediction is disabled, when the node has no outbound neighbour,
+     * which is left to ReverseLink, when one of its outbound links is durable, or when the node
+     * was already reversed by this method less than a prediction horizon ago.
+     *
+     * @param node The node to check.
+     * @return True if the node was reversed.
+     */
+    bool ReverseExpiringLinks(Ptr<LrNode> node);
+
+    /**
+     * @brief Returns the number of reversals performed by ReverseExpiringLinks.
+     * @return uint64_t The number of pre-emptive reversals.
+     */
+    uint64_t GetPreemptiveReversals() const;
+
+    /**
+     * @brief Enables the detection of the nodes cut off from the sinks.
+     *
+     * The component of the sinks is found with a BFS on a snapshot of the neighbourhood graph,
+     * which is taken again when it is older than `refresh`. A node outside that component can
+     * never reach a sink whatever the heights, so ReverseLink and ReverseSinklessNodes leave it
+     * alone until connectivity returns, instead of raising its height without bound.
+     *
+     * @param refresh The maximum age of the component snapshot.
+     */
+    void SetPartitionDetection(Time refresh);
+
+    /**
+     * @brief Checks whether a node is cut off from the sink.
+     *
+     * @param node The node to check.
+     * @return True if partition detection is enabled and the node is not in the component of the
+     *         sink.
+     */
+    bool IsPartitioned(Ptr<LrNode> node);
+
+    /**
+     * @brief Returns the number of reversals skipped because the node was cut off from the sink.
+     * @return uint64_t The number of reversals saved by the partition detection.
+     */
+    uint64_t GetSuppressedReversals() const;
+
+    /**
+     * @brief Precomputes the adjacency of a network whose nodes never move.
+     *
+     * The neighbourhood graph is stored once in compressed sparse row form. Every row is
+     * partitioned so that the outbound neighbours come before the inbound ones, and from now on
+     * the neighbour queries only scan the row of the node instead of the whole container.
+     *
+     * The node IDs must match their index in the container.
+     */
+    void BuildStaticAdjacency();
+
+    /**
+     * @brief Returns whether the static adjacency has been built.
+     * @return True if the neighbour queries use the precomputed adjacency.
+     */
+    bool IsStatic() const;
+
   private:
-    std::set<double> m_idHeights;
+    /**
+     * @brief Checks whether two nodes are within communication range.
+     *
+     * @param a The first node.
+     * @param b The second node.
+     * @return True if both nodes are active, closer than the maximum range and, with a link
+     *         table, their link is up.
+     */
+    bool IsLinked(Ptr<LrNode> a, Ptr<LrNode> b);
+
+    /**
+     * @brief Returns the height of a neighbour as known by a node.
+     *
+     * @param node The node querying the height.
+     * @param neighbour The neighbour.
+     * @param height Output height, from the height cache if one is set and the neighbour is not a
+     *               sink, the actual height otherwise.
+     * @return True if the height is known.
+     */
+    bool GetNeighbourHeight(Ptr<LrNode> node, Ptr<LrNode> neighbour, double& height);
+
+    /**
+     * @brief Predicts how long a link lasts.
+     *
+     * The link breaks at the maximum range or, with a link table, where its predicted signal
+     * strength falls below the threshold of the table if that happens closer. Both the LIFETIME
+     * policy and the prediction of the expiring links use this break distance.
+     *
+     * @param a The first node.
+     * @param b The second node.
+     * @return double The lifetime in seconds, as returned by LrNode::GetLinkLifetime.
+     */
+    double GetLinkLifetime(Ptr<LrNode> a, Ptr<LrNode> b) const;
+
+    /**
+     * @brief Checks whether a link is predicted to last at least the prediction horizon.
+     *
+     * @param a The first node.
+     * @param b The second node.
+     * @return True if the predicted lifetime of the link reaches the horizon, or if it cannot be
+     *         predicted.
+     */
+    bool IsDurable(Ptr<LrNode> a, Ptr<LrNode> b) const;
+
+    /**
+     * @brief Returns the slice of the static adjacency holding the neighbours of a node on one
+     * side.
+     *
+     * The columns of the slice still include the crashed nodes, which the callers skip.
+     *
+     * @param row The index of the node.
+     * @param outbound True for the outbound neighbours, false for the inbound ones.
+     * @return The indexes of the first column of the slice and past its last column.
+     */
+    std::pair<uint32_t, uint32_t> GetStaticNeighbours(uint32_t row, bool outbound) const;
+
+    /**
+     * @brief Visits the outbound or inbound neighbours of a node.
+     *
+     * With the static adjacency the neighbours are read from its slice without building a
+     * container, otherwise they are those of GetOutBoundNeighbours or GetInboundNeighbours.
+     *
+     * @param node The node whose neighbours are visited.
+     * @param outbound True for the outbound neighbours, false for the inbound ones.
+     * @param visit Called with every neighbour, returns false to stop the visit. It is a template
+     *              parameter, so the closures of the routing are not copied to the heap.
+     */
+    template <typename Visitor>
+    void ForEachNeighbour(Ptr<LrNode> node, bool outbound, Visitor visit);
+
+    /**
+     * @brief Moves the outbound neighbours of a node before its inbound ones.
+     *
+     * @param row The index of the node whose row is partitioned.
+     */
+    void PartitionRow(uint32_t row);
+
+    /**
+     * @brief Scores an outbound neighbour according to the next hop policy.
+     *
+     * @param actualNode The node forwarding the packet.
+     * @param candidate The outbound neighbour.
+     * @param destination The destination of the packet.
+     * @return double The score of the neighbour, the highest score wins.
+     */
+    double ScoreNextHop(Ptr<LrNode> actualNode, Ptr<LrNode> candidate, Ptr<LrNode> destination);
+
+    /**
+     * @brief Computes the distance from a node to the destination of a packet.
+     *
+     * @param node The node.
+     * @param destination The destination of the packet.
+     * @return double The distance to the closest sink if the destination is a sink, the distance
+     *         to the destination otherwise.
+     */
+    double GetDistanceToDestination(Ptr<LrNode> node, Ptr<LrNode> destination);
+
+    uint64_t m_reversals = 0;
+
+    double m_heightAssignmentTime = 0;
+    double m_nodeCreationTime = 0;
+
+    std::vector<bool> m_sinks;
+    std::vector<uint32_t> m_sinkIds;
+
+    Time m_predictionHorizon;
+    double m_breakDistance = 0;
+    uint64_t m_preemptiveReversals = 0;
+    std::unordered_map<uint32_t, Time> m_preemptiveTimes;
+
+    bool m_partitionDetection = false;
+    Time m_partitionRefresh;
+    Time m_partitionUpdated;
+    std::vector<bool> m_sinkComponent;
+    uint64_t m_suppressedReversals = 0;
+
+    LrLinkTable* m_linkTable = nullptr;
+    LrHeightCache* m_heightCache = nullptr;
+
+    /**
+     * @brief Hops to the sink learned by a node from a delivery.
+     */
+    struct HopEstimate
+    {
+        uint32_t hops = UINT32_MAX; //!< Number of hops, UINT32_MAX when unknown.
+        Time learned;               //!< Time of the delivery.
+    };
+
+    NextHopPolicy m_nextHopPolicy = DISTANCE;
+    std::vector<HopEstimate> m_hopEstimates;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_packetPaths;
+    Ptr<UniformRandomVariable> m_random;
+
+    std::unordered_map<uint32_t, Ptr<LrNode>> m_addressIndex;
+    std::vector<std::vector<Ipv4InterfaceAddress>> m_nodeAddresses;
+
+    bool m_static = false;
+    std::vector<Ptr<LrNode>> m_staticNodes;
+    std::vector<double> m_staticHeights;
+    std::vector<uint32_t> m_rowOffsets;
+    std::vector<uint32_t> m_columns;
+    std::vector<uint32_t> m_outboundEnd;
 };
 
+template <typename Visitor>
+void
+LrNodeContainer::ForEachNeighbour(Ptr<LrNode> node, bool outbound, Visitor visit)
+{
+    if (m_static && !m_heightCache)
+    {
+        // The adjacency is built once, the crashed nodes are skipped when it is read.
+        auto [begin, end] = GetStaticNeighbours(node->GetId(), outbound);
+        for (uint32_t k = begin; k < end; k++)
+        {
+            Ptr<LrNode> neighbour = m_staticNodes[m_columns[k]];
+            if (neighbour->IsActive() && !visit(neighbour))
+                return;
+        }
+        return;
+    }
+
+    Ptr<LrNodeContainer> neighbours =
+        outbound ? GetOutBoundNeighbours(node) : GetInboundNeighbours(node);
+    for (uint32_t i = 0; i < neighbours->GetN(); i++)
+    {
+        if (!visit(neighbours->Get(i)))
+            return;
+    }
+}
+
 #endif
\ No newline at end of file
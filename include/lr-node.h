@@ -25,6 +25,11 @@ class LrNode : public Node
   private:
     double m_height;
 
+    uint64_t m_forwarded = 0;
+    uint64_t m_reversals = 0;
+    Time m_sinklessTime;
+    bool m_active = true;
+
   public:
     /**
      * @brief Default constructor for the LrNode class.
@@ -73,6 +78,79 @@ class LrNode : public Node
      */
     double GetDistanceFrom(Ptr<LrNode> node) const;
 
+    /**
+     * @brief Predicts how long another LrNode will stay within range of this one.
+     *
+     * The two nodes are assumed to keep their current velocity, so the prediction is the first
+     * time at which their relative position reaches the given range. Nodes that do not move
+     * relative to each other are predicted to stay in range forever.
+     *
+     * @param node A Ptr to the other LrNode.
+     * @param range The communication range.
+     * @return The predicted lifetime of the link in seconds, 0 if the nodes are already out of
+     *         range and infinity if they never leave it. Returns -1 if either node has no
+     *         MobilityModel.
+     */
+    double GetLinkLifetime(Ptr<LrNode> node, double range) const;
+
+    /**
+     * @brief Counts the packets waiting in the wifi MAC queues of this LrNode.
+     *
+     * The best effort queue is used on QoS devices and the single DCF queue on the others.
+     *
+     * @return The number of packets queued on all the wifi devices of the node.
+     */
+    uint32_t GetQueueLength() const;
+
+    /**
+     * @brief Counts a packet forwarded by this LrNode on behalf of another node.
+     */
+    void RecordForward();
+
+    /**
+     * @brief Counts a reversal that changed the height of this LrNode.
+     */
+    void RecordReversal();
+
+    /**
+     * @brief Adds to the time this LrNode spent without outbound neighbours.
+     * @param time The time to add.
+     */
+    void AddSinklessTime(Time time);
+
+    /**
+     * @brief Gets the number of packets forwarded by this LrNode.
+     * @return The number of forwarded packets.
+     */
+    uint64_t GetForwarded() const;
+
+    /**
+     * @brief Gets the number of reversals performed by this LrNode.
+     * @return The number of reversals.
+     */
+    uint64_t GetReversals() const;
+
+    /**
+     * @brief Gets the time this LrNode spent without outbound neighbours.
+     * @return The sink-less time, as sampled by the heatmap.
+     */
+    Time GetSinklessTime() const;
+
+    /**
+     * @brief Marks this LrNode as crashed or running.
+     *
+     * A crashed node is never a neighbour of any other node, see LrChurnInjector.
+     *
+     * @param active False when the node crashes, true when it rejoins.
+     */
+    void SetActive(bool active);
+
+    /**
+     * @brief Checks whether this LrNode is running.
+     * @return False if the node has crashed and not rejoined yet.
+     */
+    bool IsActive() const;
+
     /**
      * @brief Retrieves the IPv4 address associated with this LrNode.
      *
@@ -1,13 +1,19 @@
 #ifndef LINK_REVERSAL_ROUTING_H
 #define LINK_REVERSAL_ROUTING_H
 
+#include "lr-node.h"
+
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4.h"
 #include "ns3/node-container.h"
 #include "ns3/packet.h"
 
+#include <vector>
+
 using namespace ns3;
 
+class SimulationHelper;
+
 /**
  * \class LinkReversalRouting
  * @brief Implements the logic for the Link Reversal Routing protocol.
@@ -16,6 +22,11 @@ using namespace ns3;
  * The two virtual methods, RouteInput and RouteOutput, perform similar functions,
  * with the key difference being that RouteInput is called when a packet arrives
  * at a node, while RouteOutput is called when a packet is generated at the node.
+ *
+ * The LrNode, the simulation helper and the addresses of the node are resolved once, when the
+ * IPv4 object is set and when the interfaces and addresses change, so the routing methods do not
+ * have to look them up for every packet. A node can have more than one interface: packets are
+ * sent on an interface that shares a subnet with one of the interfaces of the next hop.
  */
 class LinkReversalRouting : public Ipv4RoutingProtocol
 {
@@ -142,6 +153,45 @@ class LinkReversalRouting : public Ipv4RoutingProtocol
      * @param address The Ipv4InterfaceAddress that was removed.
      */
     void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+
+  private:
+    /**
+     * @brief An address of an interface that is up, with the device it belongs to.
+     */
+    struct Interface
+    {
+        uint32_t index;               //!< Index of the interface in the IPv4 object.
+        Ipv4InterfaceAddress address; //!< Address assigned to the interface.
+        Ptr<NetDevice> device;        //!< Device of the interface.
+    };
+
+    /**
+     * @brief Builds the route towards a neighbour.
+     *
+     * The interfaces are scanned in round robin order, starting after the one used by the
+     * previous route, and the first one sharing a subnet with the next hop is used.
+     *
+     * @param nextHop The neighbour the packet is forwarded to.
+     * @param destination The final destination of the packet.
+     * @param oif The output device requested by the caller, or nullptr for any device.
+     * @return Ptr<Ipv4Route> The route, or nullptr if no interface reaches the next hop.
+     */
+    Ptr<Ipv4Route> BuildRoute(Ptr<LrNode> nextHop,
+                              Ipv4Address destination,
+                              Ptr<const NetDevice> oif);
+
+    /**
+     * @brief Starts routing over an address of an interface that is up.
+     *
+     * @param interface The index of the interface, which must not be the loopback.
+     * @param address The address of the interface.
+     */
+    void AddInterface(uint32_t interface, Ipv4InterfaceAddress address);
+
+    Ptr<LrNode> m_lrNode;
+    SimulationHelper* m_helper = nullptr;
+    std::vector<Interface> m_interfaces;
+    uint32_t m_nextInterface = 0;
 };
 
 #endif
\ No newline at end of file
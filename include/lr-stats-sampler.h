@@ -0,0 +1,83 @@
+#ifndef LR_STATS_SAMPLER_H
+#define LR_STATS_SAMPLER_H
+
+#include "lr-node-container.h"
+
+#include "ns3/core-module.h"
+#include "ns3/nstime.h"
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \class LrStatsSampler
+ * @brief Streams a time series of the routing state to a CSV file.
+ *
+ * Every interval the sampler takes a snapshot of the neighbourhood graph and writes one row with
+ * the reversals per second since the previous sample, the mean and minimum outbound degree of the
+ * running nodes other than the sinks, the number of sink-less nodes and the packets in flight and
+ * delivered so far. The rows go through a large stream buffer, so the file is only written a
+ * few times per run even with many samples.
+ */
+class LrStatsSampler
+{
+  public:
+    /**
+     * @brief Sets the functions returning the packet counters of the simulation.
+     *
+     * @param inFlight Returns the packets sent and neither delivered nor dropped.
+     * @param delivered Returns the packets delivered so far.
+     */
+    void SetPacketCounters(std::function<uint64_t()> inFlight, std::function<uint64_t()> delivered);
+
+    /**
+     * @brief Opens the CSV file and starts sampling.
+     *
+     * The first sample is taken immediately, the following ones every `interval`.
+     *
+     * @param nodes The container holding the nodes of the simulation.
+     * @param interval The time between two samples.
+     * @param filename The path of the CSV file.
+     * @return True if the file could be opened.
+     */
+    bool Start(LrNodeContainer* nodes, Time interval, const std::string& filename);
+
+    /**
+     * @brief Flushes and closes the CSV file.
+     */
+    void Stop();
+
+    /**
+     * @brief Returns the number of samples written.
+     * @return uint32_t The number of samples.
+     */
+    uint32_t GetSamples() const;
+
+  private:
+    /**
+     * @brief Takes a sample and schedules the next one.
+     */
+    void DoSample();
+
+    LrNodeContainer* m_nodes = nullptr;
+    Time m_interval;
+
+    std::function<uint64_t()> m_inFlight;
+    std::function<uint64_t()> m_delivered;
+
+    std::vector<char> m_buffer;
+    std::ofstream m_out;
+
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_columns;
+
+    uint64_t m_lastReversals = 0;
+    Time m_lastTime;
+    uint32_t m_samples = 0;
+};
+
+#endif
@@ -1,7 +1,14 @@
 #ifndef LINK_REVERSAL_HELPER_H
 #define LINK_REVERSAL_HELPER_H
 
+#include "lr-checkpoint.h"
+#include "lr-churn-injector.h"
+#include "lr-dag-monitor.h"
+#include "lr-failure-stats.h"
+#include "lr-heatmap.h"
+#include "lr-link-table.h"
 #include "lr-node-container.h"
+#include "lr-stats-sampler.h"
 
 #include "ns3/applications-module.h"
 #include "ns3/core-module.h"
@@ -12,6 +19,10 @@
 #include "ns3/wifi-module.h"
 #include "ns3/yans-wifi-helper.h"
 
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
 using namespace ns3;
 
 /**
@@ -33,11 +44,19 @@ class SimulationHelper
     uint32_t m_total_packet = 0;
     uint32_t m_success = 0;
     uint32_t m_failure = 0;
+    uint64_t m_hops = 0;
 
     bool m_enableBenchmark = false;
 
     std::pair<Time, Time> m_benchmark_times = {Seconds(0), Seconds(0)};
 
+    LrDagMonitor m_dagMonitor;
+    LrFailureStats m_failureStats;
+    LrStatsSampler m_statsSampler;
+    LrHeatmap m_heatmap;
+    LrChurnInjector m_churn;
+    LrHeightCache m_heightCache;
+
     /**
      * @brief Starts the simulation with the configured parameters.
      *
@@ -82,6 +101,77 @@ class SimulationHelper
      */
     void setSpeed(float speed);
 
+    /**
+     * @brief Records the time between the transmission of a packet by the source application
+     * and its drop by the routing protocol.
+     *
+     * @param packet The packet dropped.
+     */
+    void packetFailed(Ptr<const Packet> packet);
+
+    /**
+     * @brief Returns the mean time between the transmission of a packet by the source
+     * application and its reception by the sink application.
+     *
+     * @return double The mean delivery time in seconds, 0 if no packet was delivered.
+     */
+    double getMeanDeliveryTime() const;
+
+    /**
+     * @brief Returns a percentile of the delivery times, with the nearest-rank method.
+     *
+     * @param percentile The percentile, between 0 and 100.
+     * @return double The delivery time in seconds, 0 if no packet was delivered.
+     */
+    double getDeliveryTimePercentile(double percentile) const;
+
+    /**
+     * @brief Returns the application throughput received by the sink.
+     * @return double The throughput over the whole simulation, in kbit/s.
+     */
+    double getThroughput() const;
+
+    /**
+     * @brief Returns the mean number of hops taken by the packets delivered to a sink.
+     * @return double The mean hop count, 0 if no packet was delivered by link reversal.
+     */
+    double getMeanHopCount() const;
+
+    /**
+     * @brief Returns the fraction of the packets sent by the sources that reached the sink.
+     * @return double The delivery ratio, measured by the applications.
+     */
+    double getDeliveryRatio() const;
+
+    /**
+     * @brief Checks whether the routing overhead is measured.
+     *
+     * Link reversal reads the heights of the neighbours directly instead of sending beacons, so
+     * it has no overhead to measure, which is not the same as no overhead at all.
+     *
+     * @return True for the baseline protocols, false for link reversal.
+     */
+    bool hasControlPackets() const;
+
+    /**
+     * @brief Returns the number of routing packets sent by the nodes.
+     * @return uint64_t The control packets, only meaningful if hasControlPackets is true.
+     */
+    uint64_t getControlPackets() const;
+
+    /**
+     * @brief Returns the size of the routing packets sent by the nodes.
+     * @return uint64_t The control bytes, IPv4 headers included.
+     */
+    uint64_t getControlBytes() const;
+
+    /**
+     * @brief Returns the wall-clock time spent from the start of the setup to the end of the
+     * simulation.
+     * @return double The wall-clock time in seconds.
+     */
+    double getWallClockTime() const;
+
     /**
      * @brief Provides a singleton instance of the SimulationHelper class.
      *
@@ -98,7 +188,8 @@ class SimulationHelper
      * @brief Configures the physical environment for the simulation.
      *
      * This method sets up the physical layout and mobility models for the
-     * simulation based on the maximum number of nodes.
+     * simulation based on the maximum number of nodes. When the static topology is requested,
+     * the nodes keep their initial grid position.
      *
      * @param maxNodes The maximum number of nodes to configure in the environment.
      */
@@ -108,8 +199,9 @@ class SimulationHelper
      * @brief Configures the physical layer settings for the simulation.
      *
      * This method sets up the Wi-Fi network using 802.11ax standard in ad-hoc mode,
-     * with a fixed RSS loss model to simulate a constant signal strength. It creates
-     * a wireless channel with a constant speed propagation delay model and installs
+     * with a fixed RSS loss model to simulate a constant signal strength, or with a log-distance
+     * loss model when the realistic propagation is requested. For each radio it
+     * creates a wireless channel with a constant speed propagation delay model and installs
      * network devices on the nodes. Optionally, it enables PCAP and ASCII tracing.
      *
      * @param enablePcap A flag indicating whether to enable PCAP tracing for packet capture.
@@ -117,16 +209,146 @@ class SimulationHelper
      */
     void setPhysicalLayer(bool enablePcap, bool enableAscii);
 
+    /**
+     * @brief Builds the link table from the signal strength measured by the wifi devices and
+     * makes the nodes use it to decide their neighbours.
+     *
+     * The signal strength of the links that have not been heard recently is predicted with the
+     * same loss model used by the channel.
+     */
+    void setLinkTable();
+
+    /**
+     * @brief Counts a data frame that has to be retransmitted by the MAC.
+     *
+     * @param address The address of the destination station.
+     */
+    void macTxDataFailed(Mac48Address address);
+
+    /**
+     * @brief Counts a data frame dropped by the MAC after the last retransmission.
+     *
+     * @param address The address of the destination station.
+     */
+    void macTxFinalDataFailed(Mac48Address address);
+
+    /**
+     * @brief Prints the MAC retransmissions and drops and, when the link table is used, its
+     * measurements and link transitions.
+     */
+    void printMacStats() const;
+
+    /**
+     * @brief Prints the packets dropped in partitions cut off from the sink, the reversals saved
+     * and the mean time taken by the routing protocol to drop a packet.
+     */
+    void printPartitions() const;
+
     /**
      * @brief Configures the network layer for the simulation.
      *
      * This method sets up the network layer by installing the internet stack on the nodes,
      * assigning IP addresses to the devices, and configuring the Link Reversal Routing protocol
-     * for each node. It initializes the nodes with a specified IPv4 address range and associates
-     * a custom routing protocol with each node's IPv4 object.
+     * for each node. It initializes the nodes with a specified IPv4 address range, one subnet per
+     * radio, and associates a custom routing protocol with each node's IPv4 object.
+     *
+     * When the fast setup is enabled, the internet stack is replaced by the one installed by
+     * installFastStack.
      */
     void setNetworkLayer();
 
+    /**
+     * @brief Installs the minimal IPv4 stack needed by the routing-only experiments.
+     *
+     * Only ARP, IPv4, ICMPv4, the traffic control layer and UDP are aggregated to the node: the
+     * IPv4 interfaces cannot work without ARP and the traffic control layer, and IPv4 forwarding
+     * dereferences ICMPv4 when the TTL expires. ARP is connected to the traffic control layer,
+     * through which it sends its requests. TCP, the whole IPv6 stack, the packet sockets and
+     * the default list routing, which would be replaced by LinkReversalRouting anyway, are skipped.
+     * UDP is only needed by the nodes running an application, the relays forward at the IPv4
+     * layer.
+     *
+     * @param node The node on which the stack is installed.
+     * @param udp Whether UDP is installed.
+     */
+    void installFastStack(Ptr<Node> node, bool udp);
+
+    /**
+     * @brief Checks whether a node runs the application of a source or of a sink.
+     *
+     * @param nodeId The ID of the node.
+     * @return True if the node is a source or a sink.
+     */
+    bool hasApplications(uint32_t nodeId) const;
+
+    /**
+     * @brief Runs a setup phase and records its wall-clock time and, when the memory report is
+     * enabled, the resident memory it adds.
+     *
+     * @param name The name of the phase, used in the timing report.
+     * @param phase The function that performs the phase.
+     */
+    void runPhase(const std::string& name, std::function<void()> phase);
+
+    /**
+     * @brief Installs a component on the nodes and, when the memory report is enabled, records
+     * the resident memory it adds.
+     *
+     * @param name The name of the component, used in the memory report.
+     * @param install The function that installs the component.
+     */
+    void measureComponent(const std::string& name, std::function<void()> install);
+
+    /**
+     * @brief Records the wall-clock time elapsed between the start of the setup and the first
+     * event scheduled by the helper.
+     *
+     * The event is scheduled right before the simulation starts, so the measured time also
+     * includes the initialization events that the nodes schedule at time 0.
+     */
+    void recordFirstEvent();
+
+    /**
+     * @brief Prints the wall-clock time of each setup phase, the time to the first event and the
+     * throughput of the event scheduler during the run.
+     */
+    void printTimings() const;
+
+    /**
+     * @brief Prints the resident memory per node added by each component installed on the
+     * nodes, the rest of the setup and the total.
+     *
+     * The components (the nodes themselves, the wifi devices, the mobility models, the internet
+     * stack, the routing, the addresses and the applications) are measured on their own, so the
+     * footprint of the wifi devices is not mixed with the traces installed next to them.
+     */
+    void printMemory() const;
+
+    /**
+     * @brief Reads the resident set size of the process.
+     * @return uint64_t The resident memory in bytes, or 0 if it cannot be read.
+     */
+    static uint64_t getResidentBytes();
+
+    /**
+     * @brief Restores the destination-oriented DAG in the background.
+     *
+     * Every maintenance interval the sink-less nodes are swept and reversed, so packets do not
+     * have to pay for the repair after a topology change. Each sweep performs at most as many
+     * reversals as there are nodes, the remaining work is left to the following sweeps.
+     */
+    void runMaintenance();
+
+    /**
+     * @brief Saves a checkpoint of the nodes to the checkpoint file.
+     */
+    void saveCheckpoint();
+
+    /**
+     * @brief Prints the number of maintenance sweeps, their reversals and their wall-clock cost.
+     */
+    void printMaintenance() const;
+
     /**
      * @brief Configures the application layer for the simulation.
      *
@@ -137,6 +359,33 @@ class SimulationHelper
      */
     void setApplicationLayer();
 
+    /**
+     * @brief Records the transmission time and the flow of a packet sent by a source application.
+     *
+     * @param packet The packet sent.
+     */
+    void packetSent(Ptr<const Packet> packet);
+
+    /**
+     * @brief Records the delivery time of a packet received by the sink application.
+     *
+     * @param packet The packet received.
+     * @param from The address of the sender.
+     */
+    void packetReceived(Ptr<const Packet> packet, const Address& from);
+
+    /**
+     * @brief Counts the routing packets sent by the IPv4 layer of a node.
+     *
+     * Every UDP packet that is not addressed to the sink application is a control packet of
+     * the routing protocol.
+     *
+     * @param packet The packet sent, with its IPv4 header.
+     * @param ipv4 The IPv4 object of the node.
+     * @param interface The index of the output interface.
+     */
+    void ipv4Tx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
     uint32_t m_maxNodes = 10;
     uint32_t m_sinkNodeId = 0;
     uint32_t m_sourceNodeId = 0;
@@ -147,6 +396,121 @@ class SimulationHelper
     float m_speed = 1.0;
     bool m_enablePcap = false;
     bool m_enableAscii = false;
+    bool m_enableMonitor = false;
+    double m_monitorInterval = 1.0;
+    std::string m_monitorFile = "";
+    bool m_enableTiming = false;
+    bool m_fastSetup = false;
+    double m_checkpointAt = 0;
+    std::string m_checkpointFile = "lra-checkpoint.bin";
+    std::string m_restoreFile = "";
+    LrCheckpoint m_checkpoint;
+
+    bool m_static = false;
+    uint32_t m_radios = 1;
+    std::vector<NetDeviceContainer> m_radioDevices;
+    bool m_proactive = false;
+    double m_maintenanceInterval = 1.0;
+
+    uint32_t m_maintenanceSweeps = 0;
+    uint64_t m_maintenanceReversals = 0;
+    double m_maintenanceTime = 0;
+
+    bool m_rssNeighbours = false;
+    double m_rssThreshold = -73;
+    double m_rssHysteresis = 3;
+    std::string m_lossModel = "fixed";
+    LrLinkTable m_linkTable;
+
+    std::string m_heatmapFile = "";
+    uint32_t m_heatmapBins = 32;
+    double m_heatmapInterval = 1.0;
+
+    bool m_failureReport = false;
+    uint32_t m_hotspots = 0;
+
+    bool m_macStats = false;
+    uint64_t m_macRetransmissions = 0;
+    uint64_t m_macFinalFailures = 0;
+
+    std::string m_nextHop = "distance";
+    LrNodeContainer::NextHopPolicy m_nextHopPolicy = LrNodeContainer::DISTANCE;
+
+    double m_sampleInterval = 1.0;
+    std::string m_sampleFile = "";
+
+    std::string m_protocol = "lr";
+    uint64_t m_controlPackets = 0;
+    uint64_t m_controlBytes = 0;
+    double m_wallClockTime = 0;
+
+    bool m_predictive = false;
+    double m_predictionHorizon = 1;
+
+    bool m_learnedHeights = false;
+    double m_heightStaleness = 2;
+
+    bool m_partitionDetection = false;
+    double m_partitionInterval = 0.5;
+    std::vector<double> m_failureLatencies;
+
+    std::string m_failSpec;
+    double m_churnRate = 0;
+    double m_churnDowntime = 10;
+
+    uint32_t m_flows = 1;
+    double m_interval = 1.0;
+    std::vector<uint32_t> m_sourceNodes;
+    std::string m_sinksSpec;
+    std::vector<uint32_t> m_sinkNodes;
+
+    uint64_t m_packetsSent = 0;
+    uint64_t m_receivedBytes = 0;
+    /**
+     * @brief A packet sent by a source application and not yet delivered or dropped.
+     */
+    struct SentPacket
+    {
+        Time time;       //!< Time of the transmission.
+        uint32_t source; //!< ID of the source node, which identifies the flow.
+    };
+
+    std::unordered_map<uint64_t, SentPacket> m_sentPackets;
+    std::vector<double> m_deliveryTimes;
+
+    bool m_enableMemoryReport = false;
+    bool m_slim = false;
+    std::string m_wifiStandard = "ax";
+
+    /**
+     * @brief Wall-clock time and resident memory added by a setup phase.
+     */
+    struct Phase
+    {
+        std::string name;      //!< Name of the phase.
+        double seconds;        //!< Wall-clock time spent in the phase.
+        int64_t residentBytes; //!< Resident memory added by the phase.
+    };
+
+    /**
+     * @brief Resident memory added by a component installed on the nodes.
+     */
+    struct Component
+    {
+        std::string name;      //!< Name of the component.
+        int64_t residentBytes; //!< Resident memory added by the component.
+    };
+
+    std::chrono::steady_clock::time_point m_setupStart;
+    std::vector<Phase> m_phases;
+    std::vector<Component> m_components;
+    double m_firstEventTime = 0;
+    double m_runTime = 0;
+    uint64_t m_events = 0;
+    double m_simulatedTime = 0;
+
+    std::string m_scheduler = "map";
+    std::string m_schedulerType = "ns3::MapScheduler";
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#ifndef SWEEP_DRIVER_H
+#define SWEEP_DRIVER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * \class SweepDriver
+ * @brief Runs the simulator over a parameter sweep with an adaptive number of repetitions.
+ *
+ * For every value of the swept parameter the simulator is run with increasing `--RngRun` seeds
+ * until the 95% confidence interval of every metric is narrower than the target width, or until
+ * the maximum number of runs is reached. The metrics are read from the `Name: value` lines
+ * printed by the simulator. Runs whose output cannot be parsed are counted and reported instead
+ * of being silently retried. A point whose first run prints none of the metrics, such as a
+ * configuration the simulator rejects, is abandoned and the output of that run is printed.
+ */
+class SweepDriver
+{
+  public:
+    /**
+     * @brief Mean and confidence interval of a metric.
+     */
+    struct Statistic
+    {
+        uint32_t runs = 0;     //!< Number of samples.
+        double mean = 0;       //!< Sample mean.
+        double halfWidth = 0;  //!< Half width of the 95% confidence interval.
+    };
+
+    /**
+     * @brief Results of a single point of the sweep.
+     */
+    struct Point
+    {
+        std::string value;                          //!< Value of the swept parameter.
+        uint32_t discarded = 0;                     //!< Runs whose output could not be used.
+        std::map<std::string, Statistic> metrics;   //!< Statistics of each metric.
+    };
+
+    /**
+     * @brief Sets the simulator executable and the arguments shared by every run.
+     *
+     * @param simulator The path of the simulator executable.
+     * @param arguments The arguments passed to every run.
+     */
+    void SetSimulator(const std::string& simulator, const std::string& arguments);
+
+    /**
+     * @brief Sets the swept parameter.
+     *
+     * @param name The name of the command line option, without dashes.
+     * @param values The values taken by the option.
+     */
+    void SetParameter(const std::string& name, const std::vector<std::string>& values);
+
+    /**
+     * @brief Sets the metrics collected from the output of the simulator.
+     *
+     * @param metrics The names printed before the colon in the output lines.
+     */
+    void SetMetrics(const std::vector<std::string>& metrics);
+
+    /**
+     * @brief Sets the stopping rule.
+     *
+     * A point is complete when, for every metric, the full width of the 95% confidence interval
+     * is below `width`, or below `relativeWidth` times the absolute value of the mean when
+     * `width` is zero.
+     *
+     * @param width The absolute target width.
+     * @param relativeWidth The target width relative to the mean.
+     * @param minRuns The number of runs performed before checking the intervals.
+     * @param maxRuns The maximum number of runs of each point.
+     */
+    void SetTarget(double width, double relativeWidth, uint32_t minRuns, uint32_t maxRuns);
+
+    /**
+     * @brief Sets whether the runs where a metric is zero are discarded.
+     *
+     * @param dropZero True to discard the zero results.
+     */
+    void SetDropZero(bool dropZero);
+
+    /**
+     * @brief Runs the sweep and prints the result of every point.
+     *
+     * @return The results of every point of the sweep.
+     */
+    std::vector<Point> Run();
+
+    /**
+     * @brief Writes the results of a sweep to a CSV file.
+     *
+     * @param filename The path of the file to write.
+     * @param points The results returned by Run.
+     */
+    void WriteCsv(const std::string& filename, const std::vector<Point>& points) const;
+
+    /**
+     * @brief Returns the two-sided 95% quantile of the Student t distribution.
+     *
+     * The quantiles are exact up to 30 degrees of freedom and interpolated in 1 / degrees
+     * beyond, which is accurate to the third decimal.
+     *
+     * @param degrees The degrees of freedom.
+     * @return double The quantile.
+     */
+    static double StudentT95(uint32_t degrees);
+
+    /**
+     * @brief Checks whether every metric of a point satisfies the stopping rule set by SetTarget.
+     *
+     * @param samples The samples collected for each metric.
+     * @return True if no more runs are needed.
+     */
+    bool IsPrecise(const std::map<std::string, std::vector<double>>& samples) const;
+
+    /**
+     * @brief Computes the mean and confidence interval of a set of samples.
+     *
+     * @param samples The samples.
+     * @return Statistic The statistic of the samples.
+     */
+    static Statistic Summarize(const std::vector<double>& samples);
+
+  private:
+    /**
+     * @brief Runs the simulator once and parses its output.
+     *
+     * @param command The command line to execute.
+     * @param results Output map filled with the value of each metric.
+     * @param output Output string filled with everything the simulator printed.
+     * @return True if every metric was found in the output.
+     */
+    bool RunOnce(const std::string& command,
+                 std::map<std::string, double>& results,
+                 std::string& output) const;
+
+    std::string m_simulator;
+    std::string m_arguments;
+    std::string m_parameter;
+    std::vector<std::string> m_values;
+    std::vector<std::string> m_metrics;
+    double m_width = 0;
+    double m_relativeWidth = 0.1;
+    uint32_t m_minRuns = 5;
+    uint32_t m_maxRuns = 100;
+    bool m_dropZero = false;
+};
+
+#endif
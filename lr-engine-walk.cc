@@ -0,0 +1,102 @@
+#include "include/lr-engine.h"
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <random>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LR-Engine-Walk");
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nodes = 1000000;
+    uint32_t sink = 0;
+    uint32_t walks = 100000;
+    uint32_t ttl = 64;
+    double distance = 20;
+    double range = 25;
+    uint64_t seed = 1;
+
+    CommandLine cmd;
+    cmd.AddValue("nodes", "Number of nodes.", nodes);
+    cmd.AddValue("sink", "ID of the sink node.", sink);
+    cmd.AddValue("walks", "Number of packets walked to the sink.", walks);
+    cmd.AddValue("ttl", "Maximum number of hops of a packet.", ttl);
+    cmd.AddValue("distance", "Distance between the nodes of the grid.", distance);
+    cmd.AddValue("range", "Max communication range between nodes.", range);
+    cmd.AddValue("seed", "Seed of the random heights and sources.", seed);
+    cmd.Parse(argc, argv);
+
+    if (nodes < 2 || sink >= nodes || distance <= 0 || range <= 0)
+    {
+        NS_LOG_UNCOND("At least two nodes, a valid sink and a positive distance and range are "
+                      "required");
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // The same square grid and evenly spaced, shuffled heights as the simulator.
+    uint32_t columns = std::ceil(std::sqrt(nodes));
+    std::vector<double> x(nodes);
+    std::vector<double> y(nodes);
+    std::vector<double> heights;
+    heights.reserve(nodes);
+
+    for (uint32_t i = 0; i < nodes; i++)
+    {
+        x[i] = (i % columns) * distance;
+        y[i] = (i / columns) * distance;
+    }
+
+    double step = static_cast<double>(RAND_MAX) / (nodes - 1);
+    for (uint32_t i = 0; i < nodes - 1; i++)
+    {
+        heights.push_back((i + 1) * step);
+    }
+
+    std::mt19937_64 random(seed);
+    std::shuffle(heights.begin(), heights.end(), random);
+    heights.insert(heights.begin() + sink, 0.0);
+
+    LrEngine engine(std::move(x), std::move(y), std::move(heights), range);
+
+    auto built = std::chrono::steady_clock::now();
+
+    std::uniform_int_distribution<uint32_t> sources(0, nodes - 2);
+    uint32_t delivered = 0;
+    uint64_t totalHops = 0;
+
+    for (uint32_t w = 0; w < walks; w++)
+    {
+        uint32_t source = sources(random);
+        if (source >= sink)
+            source++;
+
+        uint32_t hops = 0;
+        if (engine.Walk(source, sink, ttl, hops))
+        {
+            delivered++;
+            totalHops += hops;
+        }
+    }
+
+    auto walked = std::chrono::steady_clock::now();
+
+    double buildTime = std::chrono::duration<double>(built - start).count();
+    double walkTime = std::chrono::duration<double>(walked - built).count();
+
+    NS_LOG_UNCOND("Nodes:\t" << engine.GetN());
+    NS_LOG_UNCOND("Edges:\t" << engine.GetEdges() / 2);
+    NS_LOG_UNCOND("Build time:\t" << buildTime);
+    NS_LOG_UNCOND("Walk time:\t" << walkTime);
+    NS_LOG_UNCOND("Walks per second:\t" << (walkTime > 0 ? walks / walkTime : 0));
+    NS_LOG_UNCOND("Mean hops:\t"
+                  << (delivered > 0 ? static_cast<double>(totalHops) / delivered : 0));
+    NS_LOG_UNCOND("Reversals:\t" << engine.GetReversals());
+    NS_LOG_UNCOND("Success: " << delivered);
+    NS_LOG_UNCOND("Failure: " << walks - delivered);
+}
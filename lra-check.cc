@@ -0,0 +1,283 @@
+#include "include/lr-checkpoint.h"
+#include "include/lr-churn-injector.h"
+#include "include/lr-engine.h"
+#include "include/sweep-driver.h"
+
+#include "ns3/core-module.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LRA-Check");
+
+namespace
+{
+uint32_t g_checks = 0;
+uint32_t g_failures = 0;
+
+/**
+ * @brief Counts a check and prints its name if it failed.
+ *
+ * @param passed Whether the check passed.
+ * @param name The description of the check.
+ */
+void
+Check(bool passed, const std::string& name)
+{
+    g_checks++;
+    if (passed)
+        return;
+
+    g_failures++;
+    NS_LOG_UNCOND("FAILED: " << name);
+}
+
+/**
+ * @brief Returns whether two doubles are equal up to a tolerance.
+ */
+bool
+Near(double a, double b, double tolerance = 1e-9)
+{
+    return std::abs(a - b) <= tolerance;
+}
+
+/**
+ * @brief Checks the graph, height and partition functions of LrEngine and a walk over them.
+ */
+void
+CheckEngine()
+{
+    Check(Near(LrEngine::GetReversedHeight(5, false, 0), 5.1),
+          "a reversal without nodes above moves just over the highest inbound neighbour");
+    Check(Near(LrEngine::GetReversedHeight(5, true, 7), 6),
+          "a reversal with nodes above moves halfway to the lowest of them");
+
+    // Three nodes on a line, only the first two are in range of each other.
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> columns;
+    LrEngine::BuildAdjacency(
+        {0, 10, 30},
+        {0, 0, 0},
+        15,
+        [](uint32_t, uint32_t, double distance) { return distance <= 15; },
+        offsets,
+        columns);
+
+    Check(offsets == std::vector<uint32_t>({0, 1, 2, 2}), "the row offsets of the graph");
+    Check(columns == std::vector<uint32_t>({1, 0}), "the links of the graph are symmetric");
+
+    // Three nodes on a line in range of their neighbours, the middle one sits between a
+    // higher and a lower neighbour.
+    LrEngine::BuildAdjacency(
+        {0, 10, 20},
+        {0, 0, 0},
+        15,
+        [](uint32_t, uint32_t, double distance) { return distance <= 15; },
+        offsets,
+        columns);
+
+    std::vector<double> heights = {3, 1, 0};
+    uint32_t split = LrEngine::PartitionRow(heights, offsets, columns, 1);
+    Check(split == offsets[1] + 1, "the middle node has one outbound neighbour");
+    Check(columns[offsets[1]] == 2, "the outbound neighbour comes before the inbound one");
+
+    // The last node is sink-less, the walk reverses it once and reaches the sink in two hops.
+    LrEngine engine({0, 10, 20}, {0, 0, 0}, {0, 2, 1}, 15);
+    Check(engine.GetEdges() == 4, "two links counted in both directions");
+
+    uint32_t hops = 0;
+    Check(!engine.Walk(2, 0, 1, hops), "the walk stops at the TTL");
+
+    bool delivered = engine.Walk(2, 0, 8, hops);
+    Check(delivered && hops == 2, "the walk reaches the sink in two hops");
+    Check(engine.GetReversals() == 1, "the sink-less node is reversed once");
+    Check(Near(engine.GetHeight(2), 2.1), "the reversed node moves above its neighbour");
+}
+
+/**
+ * @brief Checks the parsing of the scheduled failures and their validation against the sinks.
+ */
+void
+CheckChurnParsing()
+{
+    LrChurnInjector churn;
+    Check(churn.AddFailures("3:20:15,7:40"), "a failure with and one without downtime");
+    Check(churn.IsEnabled(), "the scheduled failures enable the injector");
+    Check(churn.Validate(10, {0, 1}), "failures of known nodes other than the sinks");
+    Check(!churn.Validate(5, {0}), "a failure of an unknown node");
+    Check(!churn.Validate(10, {0, 7}), "a failure of any of the sinks");
+
+    for (const std::string& spec : {"3", "3:", "3:20x", "3:20:15x", "3:-1", "3:20:-5", "x:20"})
+    {
+        LrChurnInjector malformed;
+        Check(!malformed.AddFailures(spec), "the malformed failure " + spec);
+    }
+
+    // A malformed entry discards the whole list, including the valid entries before it.
+    LrChurnInjector partial;
+    Check(!partial.AddFailures("1:5,2:"), "a list with a malformed entry");
+    Check(!partial.IsEnabled(), "no failure is scheduled from a malformed list");
+}
+
+/**
+ * @brief Writes a checkpoint file in the format of LrCheckpoint::Save.
+ *
+ * Every node i has height i and position (i, 2i, 0) and moves with velocity (1, 0, 0).
+ *
+ * @param filename The path of the file.
+ * @param n The number of nodes.
+ * @param sinkIds The IDs of the sinks.
+ * @param nodes The number of nodes actually written, fewer than n for a truncated file.
+ */
+void
+WriteCheckpoint(const std::string& filename,
+                uint32_t n,
+                const std::vector<uint32_t>& sinkIds,
+                uint32_t nodes)
+{
+    std::ofstream out(filename, std::ios::binary);
+    auto write = [&out](const auto& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    out.write("LRCK", 4);
+    write(uint32_t(2));
+    write(n);
+    write(uint32_t(sinkIds.size()));
+    for (uint32_t sinkId : sinkIds)
+        write(sinkId);
+    write(uint32_t(5));  // source
+    write(uint32_t(3));  // seed
+    write(uint64_t(42)); // run
+    write(120.5);        // time
+
+    for (uint32_t i = 0; i < nodes; i++)
+    {
+        for (double value : {double(i), double(i), 2.0 * i, 0.0, 1.0, 0.0, 0.0})
+            write(value);
+    }
+}
+
+/**
+ * @brief Returns the content of a file.
+ */
+std::string
+ReadFile(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Checks that a checkpoint survives a save and load round trip and that corrupted files
+ * are rejected.
+ */
+void
+CheckCheckpoint()
+{
+    const std::string original = "lra-check-original.bin";
+    const std::string saved = "lra-check-saved.bin";
+
+    WriteCheckpoint(original, 8, {0, 6}, 8);
+
+    LrCheckpoint checkpoint;
+    Check(checkpoint.Load(original), "a valid checkpoint is loaded");
+    Check(checkpoint.GetN() == 8, "the number of nodes of the checkpoint");
+    Check(checkpoint.GetSinkIds() == std::vector<uint32_t>({0, 6}), "every sink is restored");
+    Check(checkpoint.GetSourceId() == 5, "the source of the checkpoint");
+    Check(checkpoint.GetSeed() == 3 && checkpoint.GetRun() == 42, "the seed and run number");
+    Check(checkpoint.GetTime() == Seconds(120.5), "the time of the checkpoint");
+
+    Check(checkpoint.Save(saved), "the checkpoint is saved");
+    Check(ReadFile(saved) == ReadFile(original), "a loaded checkpoint is saved unchanged");
+
+    LrCheckpoint corrupted;
+    WriteCheckpoint(original, 8, {}, 8);
+    Check(!corrupted.Load(original), "a checkpoint without sinks is rejected");
+
+    WriteCheckpoint(original, 2, {0, 1, 1}, 2);
+    Check(!corrupted.Load(original), "a checkpoint with more sinks than nodes is rejected");
+
+    WriteCheckpoint(original, 8, {0, 8}, 8);
+    Check(!corrupted.Load(original), "a checkpoint with a sink outside the network is rejected");
+
+    WriteCheckpoint(original, 8, {0}, 7);
+    Check(!corrupted.Load(original), "a truncated checkpoint is rejected");
+
+    WriteCheckpoint(original, UINT32_MAX, {0}, 8);
+    Check(!corrupted.Load(original), "a node count larger than the file is rejected");
+
+    WriteCheckpoint(original, 4, {0}, 4);
+    Check(!corrupted.Load(original), "a source outside the network is rejected");
+
+    Check(!corrupted.Load(saved + ".missing"), "a missing checkpoint is rejected");
+
+    std::remove(original.c_str());
+    std::remove(saved.c_str());
+}
+
+/**
+ * @brief Checks the Student t quantiles and the confidence interval stopping rule of the sweep.
+ */
+void
+CheckSweepStatistics()
+{
+    Check(std::isinf(SweepDriver::StudentT95(0)), "no interval without degrees of freedom");
+    Check(Near(SweepDriver::StudentT95(1), 12.706), "the quantile at 1 degree");
+    Check(Near(SweepDriver::StudentT95(30), 2.042), "the quantile at 30 degrees");
+    Check(Near(SweepDriver::StudentT95(35), 2.030, 0.001), "the quantile at 35 degrees");
+    Check(Near(SweepDriver::StudentT95(40), 2.021), "the quantile at 40 degrees");
+    Check(Near(SweepDriver::StudentT95(60), 2.000), "the quantile at 60 degrees");
+    Check(Near(SweepDriver::StudentT95(120), 1.980), "the quantile at 120 degrees");
+    Check(Near(SweepDriver::StudentT95(1000000), 1.960, 0.001), "the normal quantile in the limit");
+
+    bool monotone = true;
+    for (uint32_t degrees = 1; degrees < 1000; degrees++)
+    {
+        if (SweepDriver::StudentT95(degrees + 1) > SweepDriver::StudentT95(degrees))
+            monotone = false;
+    }
+    Check(monotone, "the quantile never grows with the degrees of freedom");
+
+    SweepDriver::Statistic statistic = SweepDriver::Summarize({1, 2, 3});
+    Check(statistic.runs == 3 && Near(statistic.mean, 2), "the mean of the samples");
+    Check(Near(statistic.halfWidth, 4.303 / std::sqrt(3)), "the half width of the interval");
+    Check(std::isinf(SweepDriver::Summarize({5}).halfWidth), "no interval from a single sample");
+
+    SweepDriver driver;
+    driver.SetTarget(1, 0, 2, 10);
+    Check(driver.IsPrecise({{"Success", {10, 10.1, 9.9, 10}}}), "an interval below the width");
+    Check(!driver.IsPrecise({{"Success", {10, 10.1, 9.9, 10}}, {"Failure", {1, 2, 3}}}),
+          "every metric must be below the width");
+
+    driver.SetTarget(0, 0.01, 2, 10);
+    Check(!driver.IsPrecise({{"Success", {10, 10.1, 9.9, 10}}}),
+          "an interval above the width relative to the mean");
+    Check(driver.IsPrecise({{"Success", {1000, 1000.1, 999.9, 1000}}}),
+          "an interval below the width relative to the mean");
+}
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    CommandLine cmd;
+    cmd.Parse(argc, argv);
+
+    CheckEngine();
+    CheckChurnParsing();
+    CheckCheckpoint();
+    CheckSweepStatistics();
+
+    NS_LOG_UNCOND("Checks:\t" << g_checks);
+    NS_LOG_UNCOND("Failed:\t" << g_failures);
+
+    return g_failures > 0 ? 1 : 0;
+}
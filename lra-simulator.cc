@@ -20,6 +20,24 @@ main(int argc, char* argv[])
 
     NS_LOG_UNCOND("Simulation completed.");
     
+    NS_LOG_UNCOND("Mean delivery time: " << instance.getMeanDeliveryTime());
+    NS_LOG_UNCOND("Delivery time p50: " << instance.getDeliveryTimePercentile(50));
+    NS_LOG_UNCOND("Delivery time p95: " << instance.getDeliveryTimePercentile(95));
+    NS_LOG_UNCOND("Delivery time p99: " << instance.getDeliveryTimePercentile(99));
+    NS_LOG_UNCOND("Throughput: " << instance.getThroughput());
+    NS_LOG_UNCOND("Mean hop count: " << instance.getMeanHopCount());
+    NS_LOG_UNCOND("Delivery ratio: " << instance.getDeliveryRatio());
+    if (instance.hasControlPackets())
+    {
+        NS_LOG_UNCOND("Control packets: " << instance.getControlPackets());
+        NS_LOG_UNCOND("Control bytes: " << instance.getControlBytes());
+    }
+    else
+    {
+        NS_LOG_UNCOND("Control packets: n/a");
+        NS_LOG_UNCOND("Control bytes: n/a");
+    }
+    NS_LOG_UNCOND("Wall-clock time: " << instance.getWallClockTime());
     NS_LOG_UNCOND("Success: " << instance.m_success);
     NS_LOG_UNCOND("Failure: " << instance.m_failure);
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "include/sweep-driver.h"
+
+#include "ns3/core-module.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LRA-Sweep");
+
+// Set by CMake to the lra-simulator built next to the sweep.
+#ifndef LRA_SIMULATOR_PATH
+#define LRA_SIMULATOR_PATH "build/scratch/ns3.42-lra-simulator-default"
+#endif
+
+/**
+ * @brief Splits a comma separated list.
+ *
+ * @param list The list to split.
+ * @return The items of the list.
+ */
+std::vector<std::string>
+SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+            items.push_back(item);
+    }
+
+    return items;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string simulator = LRA_SIMULATOR_PATH;
+    std::string arguments = "";
+    std::string parameter = "nodes";
+    std::string values = "2,4,8,16,32";
+    std::string metrics = "Success,Failure";
+    std::string output = "";
+    double width = 0;
+    double relativeWidth = 0.1;
+    uint32_t minRuns = 5;
+    uint32_t maxRuns = 100;
+    bool dropZero = false;
+
+    CommandLine cmd;
+    cmd.AddValue("simulator", "Path of the lra-simulator executable.", simulator);
+    cmd.AddValue("args", "Arguments passed to every run.", arguments);
+    cmd.AddValue("param", "Name of the swept option.", parameter);
+    cmd.AddValue("values", "Comma separated values of the swept option.", values);
+    cmd.AddValue("metrics", "Comma separated names of the collected metrics.", metrics);
+    cmd.AddValue("ci-width", "Target width of the 95% confidence interval.", width);
+    cmd.AddValue("ci-relative",
+                 "Target width of the 95% confidence interval relative to the mean, used when "
+                 "ci-width is 0.",
+                 relativeWidth);
+    cmd.AddValue("min-runs", "Runs of each point before checking the intervals.", minRuns);
+    cmd.AddValue("max-runs", "Maximum number of runs of each point.", maxRuns);
+    cmd.AddValue("drop-zero", "Discard the runs where a metric is zero.", dropZero);
+    cmd.AddValue("output", "Write the results to a CSV file.", output);
+    cmd.Parse(argc, argv);
+
+    if (SplitList(metrics).empty() || SplitList(values).empty())
+    {
+        NS_LOG_UNCOND("At least one value and one metric are required");
+        return 0;
+    }
+
+    SweepDriver driver;
+    driver.SetSimulator(simulator, arguments);
+    driver.SetParameter(parameter, SplitList(values));
+    driver.SetMetrics(SplitList(metrics));
+    driver.SetTarget(width, relativeWidth, minRuns, maxRuns);
+    driver.SetDropZero(dropZero);
+
+    std::vector<SweepDriver::Point> points = driver.Run();
+
+    if (!output.empty())
+        driver.WriteCsv(output, points);
+}
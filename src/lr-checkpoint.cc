@@ -0,0 +1,222 @@
+#include "../include/lr-checkpoint.h"
+
+#include "ns3/constant-velocity-mobility-model.h"
+
+#include <fstream>
+
+NS_LOG_COMPONENT_DEFINE("LrCheckpoint");
+
+namespace
+{
+const char CHECKPOINT_MAGIC[4] = {'L', 'R', 'C', 'K'};
+const uint32_t CHECKPOINT_VERSION = 2;
+// Height, position and velocity of a node.
+const uint32_t NODE_STATE_SIZE = 7 * sizeof(double);
+} // namespace
+
+void
+LrCheckpoint::Capture(LrNodeContainer& nodes, uint32_t sourceId)
+{
+    m_sinkIds = nodes.GetSinks();
+    m_sourceId = sourceId;
+    m_seed = RngSeedManager::GetSeed();
+    m_run = RngSeedManager::GetRun();
+    m_time = Simulator::Now().GetSeconds();
+
+    m_nodes.resize(nodes.GetN());
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        Ptr<LrNode> node = nodes.Get(i);
+        Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+
+        m_nodes[i].height = node->GetHeight();
+        m_nodes[i].position = mobility->GetPosition();
+        m_nodes[i].velocity = mobility->GetVelocity();
+    }
+}
+
+bool
+LrCheckpoint::Save(const std::string& filename) const
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return false;
+    }
+
+    uint32_t n = m_nodes.size();
+    uint32_t sinks = m_sinkIds.size();
+
+    out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    out.write(reinterpret_cast<const char*>(&CHECKPOINT_VERSION), sizeof(CHECKPOINT_VERSION));
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    out.write(reinterpret_cast<const char*>(&sinks), sizeof(sinks));
+    out.write(reinterpret_cast<const char*>(m_sinkIds.data()), sinks * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&m_sourceId), sizeof(m_sourceId));
+    out.write(reinterpret_cast<const char*>(&m_seed), sizeof(m_seed));
+    out.write(reinterpret_cast<const char*>(&m_run), sizeof(m_run));
+    out.write(reinterpret_cast<const char*>(&m_time), sizeof(m_time));
+
+    for (const NodeState& state : m_nodes)
+    {
+        double values[7] = {state.height,
+                            state.position.x,
+                            state.position.y,
+                            state.position.z,
+                            state.velocity.x,
+                            state.velocity.y,
+                            state.velocity.z};
+        out.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+
+    return out.good();
+}
+
+bool
+LrCheckpoint::Load(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t n = 0;
+    uint32_t sinks = 0;
+
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+    if (!in || std::string(magic, sizeof(magic)) != std::string(CHECKPOINT_MAGIC, 4) ||
+        version != CHECKPOINT_VERSION)
+    {
+        NS_LOG_ERROR(filename << " is not a checkpoint");
+        return false;
+    }
+
+    in.read(reinterpret_cast<char*>(&n), sizeof(n));
+    in.read(reinterpret_cast<char*>(&sinks), sizeof(sinks));
+
+    // A corrupted count must not allocate more sinks than nodes.
+    if (!in || sinks == 0 || sinks > n)
+    {
+        NS_LOG_ERROR(filename << " has an invalid sink count");
+        return false;
+    }
+
+    // Nor more sinks and nodes than the file holds, before anything is allocated.
+    std::streamoff counts = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streamoff remaining = in.tellg() - counts;
+    in.seekg(counts);
+
+    uint64_t expected = sinks * uint64_t(sizeof(uint32_t)) + sizeof(m_sourceId) +
+                        sizeof(m_seed) + sizeof(m_run) + sizeof(m_time) +
+                        n * uint64_t(NODE_STATE_SIZE);
+    if (remaining < 0 || static_cast<uint64_t>(remaining) != expected)
+    {
+        NS_LOG_ERROR(filename << " does not match its node and sink counts");
+        return false;
+    }
+
+    m_sinkIds.resize(sinks);
+    in.read(reinterpret_cast<char*>(m_sinkIds.data()), sinks * sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(&m_sourceId), sizeof(m_sourceId));
+    in.read(reinterpret_cast<char*>(&m_seed), sizeof(m_seed));
+    in.read(reinterpret_cast<char*>(&m_run), sizeof(m_run));
+    in.read(reinterpret_cast<char*>(&m_time), sizeof(m_time));
+
+    m_nodes.resize(n);
+    for (NodeState& state : m_nodes)
+    {
+        double values[7];
+        in.read(reinterpret_cast<char*>(values), sizeof(values));
+
+        state.height = values[0];
+        state.position = Vector(values[1], values[2], values[3]);
+        state.velocity = Vector(values[4], values[5], values[6]);
+    }
+
+    if (!in)
+    {
+        NS_LOG_ERROR(filename << " is truncated");
+        return false;
+    }
+
+    for (uint32_t sinkId : m_sinkIds)
+    {
+        if (sinkId >= n)
+        {
+            NS_LOG_ERROR(filename << " has a sink outside the network");
+            return false;
+        }
+    }
+
+    if (m_sourceId >= n)
+    {
+        NS_LOG_ERROR(filename << " has a source outside the network");
+        return false;
+    }
+
+    return true;
+}
+
+void
+LrCheckpoint::Apply(LrNodeContainer& nodes) const
+{
+    NS_ASSERT_MSG(nodes.GetN() == m_nodes.size(), "The checkpoint has a different number of nodes");
+
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        Ptr<LrNode> node = nodes.Get(i);
+        Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+
+        node->SetHeight(m_nodes[i].height);
+        mobility->SetPosition(m_nodes[i].position);
+
+        Ptr<ConstantVelocityMobilityModel> constantVelocity =
+            DynamicCast<ConstantVelocityMobilityModel>(mobility);
+        if (constantVelocity)
+            constantVelocity->SetVelocity(m_nodes[i].velocity);
+    }
+}
+
+uint32_t
+LrCheckpoint::GetN() const
+{
+    return m_nodes.size();
+}
+
+const std::vector<uint32_t>&
+LrCheckpoint::GetSinkIds() const
+{
+    return m_sinkIds;
+}
+
+uint32_t
+LrCheckpoint::GetSourceId() const
+{
+    return m_sourceId;
+}
+
+uint32_t
+LrCheckpoint::GetSeed() const
+{
+    return m_seed;
+}
+
+uint64_t
+LrCheckpoint::GetRun() const
+{
+    return m_run;
+}
+
+Time
+LrCheckpoint::GetTime() const
+{
+    return Seconds(m_time);
+}
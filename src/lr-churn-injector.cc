@@ -0,0 +1,221 @@
+#include "../include/lr-churn-injector.h"
+
+#include "ns3/ipv4.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE("LrChurnInjector");
+
+bool
+LrChurnInjector::AddFailures(const std::string& spec)
+{
+    std::vector<Failure> failures;
+    std::stringstream entries(spec);
+    std::string entry;
+
+    while (std::getline(entries, entry, ','))
+    {
+        uint32_t nodeId = 0;
+        double at = 0;
+        double downtime = 0;
+        int consumed = 0;
+
+        // The position is recorded after the time and again after the downtime, so trailing
+        // characters are detected in both forms.
+        int fields = std::sscanf(entry.c_str(),
+                                 "%u:%lf%n:%lf%n",
+                                 &nodeId,
+                                 &at,
+                                 &consumed,
+                                 &downtime,
+                                 &consumed);
+        if (fields < 2 || consumed != static_cast<int>(entry.size()) || at < 0 || downtime < 0)
+            return false;
+
+        failures.push_back({nodeId, Seconds(at), Seconds(downtime)});
+    }
+
+    m_scheduled.insert(m_scheduled.end(), failures.begin(), failures.end());
+    return true;
+}
+
+void
+LrChurnInjector::SetChurn(double rate, Time downtime)
+{
+    m_rate = rate;
+    m_downtime = downtime;
+}
+
+bool
+LrChurnInjector::Validate(uint32_t n, const std::vector<uint32_t>& sinkIds) const
+{
+    for (const Failure& failure : m_scheduled)
+    {
+        if (failure.nodeId >= n ||
+            std::find(sinkIds.begin(), sinkIds.end(), failure.nodeId) != sinkIds.end())
+            return false;
+    }
+
+    return true;
+}
+
+bool
+LrChurnInjector::IsEnabled() const
+{
+    return !m_scheduled.empty() || m_rate > 0;
+}
+
+void
+LrChurnInjector::Start(LrNodeContainer* nodes)
+{
+    m_nodes = nodes;
+
+    for (const Failure& failure : m_scheduled)
+    {
+        Simulator::Schedule(failure.at,
+                            &LrChurnInjector::Fail,
+                            this,
+                            failure.nodeId,
+                            failure.downtime);
+    }
+
+    if (m_rate > 0)
+    {
+        m_interArrival = CreateObject<ExponentialRandomVariable>();
+        m_interArrival->SetAttribute("Mean", DoubleValue(1 / m_rate));
+        m_choice = CreateObject<UniformRandomVariable>();
+
+        Simulator::Schedule(Seconds(m_interArrival->GetValue()), &LrChurnInjector::DoChurn, this);
+    }
+}
+
+void
+LrChurnInjector::DoChurn()
+{
+    std::vector<uint32_t> running;
+    for (uint32_t i = 0; i < m_nodes->GetN(); i++)
+    {
+        if (!m_nodes->IsSink(i) && m_nodes->Get(i)->IsActive())
+            running.push_back(i);
+    }
+
+    if (!running.empty())
+        Fail(running[m_choice->GetInteger(0, running.size() - 1)], m_downtime);
+
+    Simulator::Schedule(Seconds(m_interArrival->GetValue()), &LrChurnInjector::DoChurn, this);
+}
+
+void
+LrChurnInjector::Fail(uint32_t nodeId, Time downtime)
+{
+    Ptr<LrNode> node = m_nodes->Get(nodeId);
+    if (!node->IsActive())
+        return;
+
+    NS_LOG_DEBUG("Node " << nodeId << " crashed");
+
+    node->SetActive(false);
+    SetDevicesUp(node, false);
+
+    m_failures++;
+    m_pending.push_back({Simulator::Now(), m_nodes->GetReversals(), {}});
+
+    if (downtime.IsStrictlyPositive())
+        Simulator::Schedule(downtime, &LrChurnInjector::Rejoin, this, nodeId);
+}
+
+void
+LrChurnInjector::Rejoin(uint32_t nodeId)
+{
+    NS_LOG_DEBUG("Node " << nodeId << " rejoined");
+
+    Ptr<LrNode> node = m_nodes->Get(nodeId);
+    SetDevicesUp(node, true);
+    node->SetActive(true);
+
+    m_rejoins++;
+}
+
+void
+LrChurnInjector::SetDevicesUp(Ptr<LrNode> node, bool up)
+{
+    for (uint32_t i = 0; i < node->GetNDevices(); i++)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(node->GetDevice(i));
+        if (!device)
+            continue;
+
+        if (up)
+            device->GetPhy()->ResumeFromOff();
+        else
+            device->GetPhy()->SetOffMode();
+    }
+
+    // The loopback interface stays up, the routing protocol is notified of the others.
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    for (uint32_t i = 1; ipv4 && i < ipv4->GetNInterfaces(); i++)
+    {
+        if (up)
+            ipv4->SetUp(i);
+        else
+            ipv4->SetDown(i);
+    }
+}
+
+void
+LrChurnInjector::RecordFailure(uint32_t flow)
+{
+    for (Recovery& recovery : m_pending)
+    {
+        recovery.flows.insert(flow);
+    }
+}
+
+void
+LrChurnInjector::RecordDelivery(uint32_t flow)
+{
+    uint64_t reversals = m_nodes ? m_nodes->GetReversals() : 0;
+
+    // Only the failures that disrupted this flow are recovered by its delivery, the other flows
+    // may never have crossed the crashed node.
+    auto it = m_pending.begin();
+    while (it != m_pending.end())
+    {
+        if (it->flows.count(flow) == 0)
+        {
+            it++;
+            continue;
+        }
+
+        m_recoveryTimes.push_back((Simulator::Now() - it->failed).GetSeconds());
+        m_recoveryReversals.push_back(reversals - it->reversals);
+        it = m_pending.erase(it);
+    }
+}
+
+void
+LrChurnInjector::Report() const
+{
+    NS_LOG_UNCOND("Node failures:\t" << m_failures);
+    NS_LOG_UNCOND("Node rejoins:\t" << m_rejoins);
+    NS_LOG_UNCOND("Recovered failures:\t" << m_recoveryTimes.size());
+    NS_LOG_UNCOND("Unrecovered failures:\t"
+                  << std::count_if(m_pending.begin(), m_pending.end(), [](const Recovery& r) {
+                         return !r.flows.empty();
+                     }));
+
+    if (m_recoveryTimes.empty())
+        return;
+
+    double time = std::accumulate(m_recoveryTimes.begin(), m_recoveryTimes.end(), 0.0);
+    double reversals =
+        std::accumulate(m_recoveryReversals.begin(), m_recoveryReversals.end(), uint64_t(0));
+
+    NS_LOG_UNCOND("Mean recovery time:\t" << time / m_recoveryTimes.size());
+    NS_LOG_UNCOND("Mean recovery reversals:\t" << reversals / m_recoveryReversals.size());
+}
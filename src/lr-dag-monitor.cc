@@ -0,0 +1,165 @@
+#include "../include/lr-dag-monitor.h"
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+
+NS_LOG_COMPONENT_DEFINE("LrDagMonitor");
+
+void
+LrDagMonitor::Start(LrNodeContainer* nodes, Time interval)
+{
+    m_nodes = nodes;
+    m_interval = interval;
+
+    Simulator::ScheduleNow(&LrDagMonitor::DoSample, this);
+}
+
+void
+LrDagMonitor::DoSample()
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> columns;
+    m_nodes->GetAdjacency(offsets, columns);
+
+    bool topologyChanged = !m_samples.empty() && (offsets != m_offsets || columns != m_columns);
+
+    uint32_t n = m_nodes->GetN();
+    std::vector<double> heights(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        heights[i] = m_nodes->Get(i)->GetHeight();
+    }
+
+    // The first BFS ignores the edge directions and finds the component of the sink, the second
+    // one walks the edges backwards and only visits the nodes that have a downhill path to it.
+    std::vector<bool> connected(n, false);
+    std::vector<bool> reachable(n, false);
+
+    auto bfs = [&](std::vector<bool>& visited, bool downhillOnly) {
+        // With several sinks the DAG has a root per sink and the BFS starts from all of them.
+        std::queue<uint32_t> frontier;
+        for (uint32_t sink : m_nodes->GetSinks())
+        {
+            visited[sink] = true;
+            frontier.push(sink);
+        }
+
+        uint32_t count = 0;
+        while (!frontier.empty())
+        {
+            uint32_t v = frontier.front();
+            frontier.pop();
+
+            for (uint32_t k = offsets[v]; k < offsets[v + 1]; k++)
+            {
+                uint32_t u = columns[k];
+                if (visited[u] || (downhillOnly && heights[v] > heights[u]))
+                    continue;
+
+                visited[u] = true;
+                frontier.push(u);
+                count++;
+            }
+        }
+
+        return count;
+    };
+
+    Sample sample;
+    sample.time = Simulator::Now();
+    sample.connected = bfs(connected, false);
+    sample.reachable = bfs(reachable, true);
+    sample.topologyChanged = topologyChanged;
+
+    bool converged = sample.reachable == sample.connected;
+
+    if (topologyChanged)
+    {
+        m_topologyChanges++;
+    }
+
+    // The initial configuration is treated as a topology change, so the time needed to fix the
+    // local minima of the random heights is measured as well.
+    if (!converged && !m_pending && (topologyChanged || m_samples.empty()))
+    {
+        m_pending = true;
+        m_changeTime = sample.time;
+    }
+    else if (converged && m_pending)
+    {
+        m_pending = false;
+        m_convergenceTimes.push_back(sample.time - m_changeTime);
+        NS_LOG_DEBUG("DAG converged after " << (sample.time - m_changeTime).GetSeconds() << "s");
+    }
+
+    m_samples.push_back(sample);
+    m_offsets.swap(offsets);
+    m_columns.swap(columns);
+
+    Simulator::Schedule(m_interval, &LrDagMonitor::DoSample, this);
+}
+
+void
+LrDagMonitor::Report() const
+{
+    double fractionSum = 0;
+    double minFraction = 1;
+    for (const Sample& sample : m_samples)
+    {
+        double fraction =
+            sample.connected == 0 ? 1.0 : static_cast<double>(sample.reachable) / sample.connected;
+        fractionSum += fraction;
+        minFraction = std::min(minFraction, fraction);
+    }
+
+    Time totalConvergence = Seconds(0);
+    Time maxConvergence = Seconds(0);
+    for (const Time& t : m_convergenceTimes)
+    {
+        totalConvergence += t;
+        maxConvergence = std::max(maxConvergence, t);
+    }
+
+    NS_LOG_UNCOND("DAG samples:\t" << m_samples.size());
+    NS_LOG_UNCOND("DAG topology changes:\t" << m_topologyChanges);
+    NS_LOG_UNCOND("DAG convergences:\t" << m_convergenceTimes.size());
+
+    if (!m_convergenceTimes.empty())
+    {
+        NS_LOG_UNCOND("Mean time to convergence:\t"
+                      << totalConvergence.GetSeconds() / m_convergenceTimes.size());
+        NS_LOG_UNCOND("Max time to convergence:\t" << maxConvergence.GetSeconds());
+    }
+
+    if (m_pending)
+    {
+        NS_LOG_UNCOND("DAG not converged since:\t" << m_changeTime.GetSeconds());
+    }
+
+    if (!m_samples.empty())
+    {
+        NS_LOG_UNCOND("Mean sink reachability:\t" << fractionSum / m_samples.size());
+        NS_LOG_UNCOND("Min sink reachability:\t" << minFraction);
+    }
+}
+
+void
+LrDagMonitor::WriteSamples(const std::string& filename) const
+{
+    std::ofstream out(filename);
+    if (!out.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return;
+    }
+
+    out << "time,connected,reachable,fraction,topology_changed\n";
+    for (const Sample& sample : m_samples)
+    {
+        double fraction =
+            sample.connected == 0 ? 1.0 : static_cast<double>(sample.reachable) / sample.connected;
+        out << sample.time.GetSeconds() << "," << sample.connected << "," << sample.reachable
+            << "," << fraction << "," << sample.topologyChanged << "\n";
+    }
+}
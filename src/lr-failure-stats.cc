@@ -0,0 +1,214 @@
+#include "../include/lr-failure-stats.h"
+
+#include "ns3/internet-module.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/node-list.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+NS_LOG_COMPONENT_DEFINE("LrFailureStats");
+
+void
+LrFailureStats::Start(uint16_t dataPort)
+{
+    m_dataPort = dataPort;
+    Config::Connect("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Mac/DroppedMpdu",
+                    MakeCallback(&LrFailureStats::MacDrop, this));
+    Config::Connect("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyRxDrop",
+                    MakeCallback(&LrFailureStats::PhyRxDrop, this));
+}
+
+void
+LrFailureStats::RecordFailure(uint32_t nodeId, Cause cause)
+{
+    if (nodeId >= m_nodes.size())
+        m_nodes.resize(nodeId + 1, std::array<uint64_t, CAUSES>{});
+
+    m_causes[cause]++;
+    m_nodes[nodeId][cause]++;
+}
+
+uint64_t
+LrFailureStats::GetFailures(Cause cause) const
+{
+    return m_causes[cause];
+}
+
+uint64_t
+LrFailureStats::GetMacDrops() const
+{
+    return std::accumulate(m_causes.begin() + MAC_RETRY_LIMIT, m_causes.end(), uint64_t(0));
+}
+
+void
+LrFailureStats::MacDrop(std::string context, WifiMacDropReason reason, Ptr<const WifiMpdu> mpdu)
+{
+    // The management and control frames carry no packet of the simulation.
+    if (!mpdu->GetHeader().IsData())
+        return;
+
+    // An A-MSDU carries several packets, each of them is a failure if it is a data packet.
+    uint32_t packets = 0;
+    if (mpdu->GetHeader().IsQosData() && mpdu->GetHeader().IsQosAmsdu())
+    {
+        for (auto msdu = mpdu->begin(); msdu != mpdu->end(); msdu++)
+        {
+            if (IsDataPacket(msdu->first))
+                packets++;
+        }
+    }
+    else if (IsDataPacket(mpdu->GetPacket()))
+        packets = 1;
+
+    uint32_t nodeId = 0;
+    std::sscanf(context.c_str(), "/NodeList/%u/", &nodeId);
+
+    Cause cause;
+    switch (reason)
+    {
+    case WIFI_MAC_DROP_REACHED_RETRY_LIMIT:
+        cause = MAC_RETRY_LIMIT;
+        break;
+    case WIFI_MAC_DROP_FAILED_ENQUEUE:
+        cause = MAC_QUEUE;
+        break;
+    case WIFI_MAC_DROP_EXPIRED_LIFETIME:
+        cause = MAC_LIFETIME;
+        break;
+    default:
+        cause = MAC_OTHER;
+        break;
+    }
+
+    for (uint32_t i = 0; i < packets; i++)
+        RecordFailure(nodeId, cause);
+}
+
+bool
+LrFailureStats::IsDataPacket(Ptr<const Packet> msdu) const
+{
+    Ptr<Packet> copy = msdu->Copy();
+
+    LlcSnapHeader llc;
+    if (copy->GetSize() < llc.GetSerializedSize())
+        return false;
+
+    copy->RemoveHeader(llc);
+    if (llc.GetType() != Ipv4L3Protocol::PROT_NUMBER)
+        return false;
+
+    Ipv4Header ipHeader;
+    copy->RemoveHeader(ipHeader);
+    if (ipHeader.GetProtocol() != UdpL4Protocol::PROT_NUMBER)
+        return false;
+
+    UdpHeader udpHeader;
+    copy->PeekHeader(udpHeader);
+    return udpHeader.GetDestinationPort() == m_dataPort;
+}
+
+void
+LrFailureStats::PhyRxDrop(std::string context,
+                          Ptr<const Packet> packet,
+                          WifiPhyRxfailureReason reason)
+{
+    uint32_t nodeId = 0;
+    uint32_t deviceId = 0;
+    if (std::sscanf(context.c_str(), "/NodeList/%u/DeviceList/%u/", &nodeId, &deviceId) != 2)
+        return;
+
+    // Every node overhears the frames of its neighbours, only the frames addressed to the node
+    // are losses.
+    WifiMacHeader header;
+    packet->PeekHeader(header);
+
+    Address address = NodeList::GetNode(nodeId)->GetDevice(deviceId)->GetAddress();
+    if (!header.IsData() || header.GetAddr1() != Mac48Address::ConvertFrom(address))
+        return;
+
+    if (nodeId >= m_phyLosses.size())
+        m_phyLosses.resize(nodeId + 1, 0);
+
+    m_phyLosses[nodeId]++;
+}
+
+std::string
+LrFailureStats::GetCauseName(Cause cause)
+{
+    switch (cause)
+    {
+    case NO_ROUTE_OUTPUT:
+        return "no route at source";
+    case NO_ROUTE_INPUT:
+        return "no route at relay";
+    case TTL_EXPIRED:
+        return "TTL expired";
+    case PARTITIONED:
+        return "partitioned";
+    case MAC_RETRY_LIMIT:
+        return "MAC retry limit";
+    case MAC_QUEUE:
+        return "MAC queue full";
+    case MAC_LIFETIME:
+        return "MAC queue lifetime";
+    default:
+        return "MAC other";
+    }
+}
+
+void
+LrFailureStats::Report() const
+{
+    for (uint32_t cause = 0; cause < CAUSES; cause++)
+    {
+        NS_LOG_UNCOND("Failures " << GetCauseName(static_cast<Cause>(cause)) << ":\t"
+                                  << m_causes[cause]);
+    }
+
+    NS_LOG_UNCOND("PHY frames lost:\t"
+                  << std::accumulate(m_phyLosses.begin(), m_phyLosses.end(), uint64_t(0)));
+}
+
+void
+LrFailureStats::ReportHotspots(uint32_t count) const
+{
+    std::vector<std::pair<uint64_t, uint32_t>> totals;
+    for (uint32_t i = 0; i < m_nodes.size(); i++)
+    {
+        uint64_t total = std::accumulate(m_nodes[i].begin(), m_nodes[i].end(), uint64_t(0));
+        if (total > 0)
+            totals.push_back({total, i});
+    }
+
+    count = std::min<uint32_t>(count, totals.size());
+    std::partial_sort(totals.begin(),
+                      totals.begin() + count,
+                      totals.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.first > b.first || (a.first == b.first && a.second < b.second);
+                      });
+
+    for (uint32_t rank = 0; rank < count; rank++)
+    {
+        uint32_t node = totals[rank].second;
+
+        std::string breakdown;
+        for (uint32_t cause = 0; cause < CAUSES; cause++)
+        {
+            if (m_nodes[node][cause] == 0)
+                continue;
+
+            breakdown += (breakdown.empty() ? "" : ", ") +
+                         GetCauseName(static_cast<Cause>(cause)) + " " +
+                         std::to_string(m_nodes[node][cause]);
+        }
+
+        uint64_t phyLosses = node < m_phyLosses.size() ? m_phyLosses[node] : 0;
+
+        NS_LOG_UNCOND("Hotspot " << rank + 1 << ":\t node " << node << ", " << totals[rank].first
+                                 << " failures (" << breakdown << "), " << phyLosses
+                                 << " PHY frames lost");
+    }
+}
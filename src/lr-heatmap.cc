@@ -0,0 +1,136 @@
+#include "../include/lr-heatmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+NS_LOG_COMPONENT_DEFINE("LrHeatmap");
+
+void
+LrHeatmap::Start(LrNodeContainer* nodes, Time interval)
+{
+    m_nodes = nodes;
+    m_interval = interval;
+
+    Simulator::Schedule(m_interval, &LrHeatmap::DoSample, this);
+}
+
+void
+LrHeatmap::DoSample()
+{
+    m_nodes->GetAdjacency(m_offsets, m_columns);
+
+    for (uint32_t i = 0; i < m_nodes->GetN(); i++)
+    {
+        if (m_nodes->IsSinkless(i, m_offsets, m_columns))
+            m_nodes->Get(i)->AddSinklessTime(m_interval);
+    }
+
+    Simulator::Schedule(m_interval, &LrHeatmap::DoSample, this);
+}
+
+bool
+LrHeatmap::Write(const std::string& filename, uint32_t bins) const
+{
+    uint32_t n = m_nodes->GetN();
+    if (n == 0 || bins == 0)
+        return false;
+
+    std::vector<Vector> positions(n);
+    double minX = INFINITY;
+    double minY = INFINITY;
+    double maxX = -INFINITY;
+    double maxY = -INFINITY;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        positions[i] = m_nodes->Get(i)->GetObject<MobilityModel>()->GetPosition();
+        minX = std::min(minX, positions[i].x);
+        minY = std::min(minY, positions[i].y);
+        maxX = std::max(maxX, positions[i].x);
+        maxY = std::max(maxY, positions[i].y);
+    }
+
+    // A square grid keeps the aspect ratio of the area, the last bin includes the maximum.
+    double side = std::max({maxX - minX, maxY - minY, 1.0});
+    double binSize = side / bins;
+
+    std::vector<Bin> grid(bins * bins);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t column = std::min<uint32_t>((positions[i].x - minX) / binSize, bins - 1);
+        uint32_t row = std::min<uint32_t>((positions[i].y - minY) / binSize, bins - 1);
+
+        Ptr<LrNode> node = m_nodes->Get(i);
+        Bin& bin = grid[row * bins + column];
+        bin.nodes++;
+        bin.forwarded += node->GetForwarded();
+        bin.reversals += node->GetReversals();
+        bin.sinkless += node->GetSinklessTime().GetSeconds();
+    }
+
+    size_t extension = filename.rfind(".pgm");
+    if (extension != std::string::npos && extension == filename.size() - 4)
+    {
+        std::string stem = filename.substr(0, extension);
+        std::vector<double> forwarded(grid.size());
+        std::vector<double> reversals(grid.size());
+        std::vector<double> sinkless(grid.size());
+        for (size_t i = 0; i < grid.size(); i++)
+        {
+            forwarded[i] = grid[i].forwarded;
+            reversals[i] = grid[i].reversals;
+            sinkless[i] = grid[i].sinkless;
+        }
+
+        return WritePgm(stem + "-forwarded.pgm", bins, forwarded) &&
+               WritePgm(stem + "-reversals.pgm", bins, reversals) &&
+               WritePgm(stem + "-sinkless.pgm", bins, sinkless);
+    }
+
+    std::ofstream out(filename);
+    if (!out.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return false;
+    }
+
+    out << "row,column,x,y,nodes,forwarded,reversals,sinkless_time\n";
+    for (uint32_t row = 0; row < bins; row++)
+    {
+        for (uint32_t column = 0; column < bins; column++)
+        {
+            const Bin& bin = grid[row * bins + column];
+            out << row << "," << column << "," << minX + (column + 0.5) * binSize << ","
+                << minY + (row + 0.5) * binSize << "," << bin.nodes << "," << bin.forwarded << ","
+                << bin.reversals << "," << bin.sinkless << "\n";
+        }
+    }
+
+    return out.good();
+}
+
+bool
+LrHeatmap::WritePgm(const std::string& filename, uint32_t bins, const std::vector<double>& values)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return false;
+    }
+
+    double maxValue = *std::max_element(values.begin(), values.end());
+
+    // The first row of the image is the top of the area, where y is largest.
+    out << "P5\n" << bins << " " << bins << "\n255\n";
+    for (uint32_t row = bins; row > 0; row--)
+    {
+        for (uint32_t column = 0; column < bins; column++)
+        {
+            double value = values[(row - 1) * bins + column];
+            out.put(static_cast<char>(maxValue > 0 ? std::lround(255 * value / maxValue) : 0));
+        }
+    }
+
+    return out.good();
+}
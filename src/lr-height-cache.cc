@@ -0,0 +1,141 @@
+#include "../include/lr-height-cache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE("LrHeightCache");
+
+void
+LrHeightCache::Start(Time staleness)
+{
+    m_enabled = true;
+    m_staleness = staleness;
+
+    Config::Connect("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/MonitorSnifferRx",
+                    MakeCallback(&LrHeightCache::SnifferRx, this));
+}
+
+bool
+LrHeightCache::IsEnabled() const
+{
+    return m_enabled;
+}
+
+void
+LrHeightCache::TagPacket(Ptr<LrNode> node, Ptr<Packet> packet)
+{
+    LrHeightTag tag;
+    tag.AddEntry({node->GetId(), node->GetHeight(), 0});
+
+    // The freshest learned heights are relayed, the stale ones would be discarded anyway.
+    uint32_t id = node->GetId();
+    if (id < m_learned.size())
+    {
+        std::vector<std::pair<Time, uint32_t>> fresh;
+        for (const auto& [neighbour, learned] : m_learned[id])
+        {
+            if (Simulator::Now() - learned.time < m_staleness)
+                fresh.push_back({learned.time, neighbour});
+        }
+
+        uint32_t count = std::min<uint32_t>(fresh.size(), LrHeightTag::MAX_ENTRIES - 1);
+        std::partial_sort(fresh.begin(),
+                          fresh.begin() + count,
+                          fresh.end(),
+                          [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const Learned& learned = m_learned[id][fresh[i].second];
+            int64_t age = (Simulator::Now() - learned.time).GetMilliSeconds();
+            tag.AddEntry({fresh[i].second,
+                          learned.height,
+                          static_cast<uint16_t>(std::min<int64_t>(age, UINT16_MAX))});
+        }
+    }
+
+    packet->ReplacePacketTag(tag);
+
+    m_taggedPackets++;
+    m_piggybackedBytes += tag.GetSerializedSize();
+}
+
+bool
+LrHeightCache::GetHeight(Ptr<LrNode> node, Ptr<LrNode> neighbour, double& height)
+{
+    m_lookups++;
+
+    uint32_t id = node->GetId();
+    if (id < m_learned.size())
+    {
+        auto learned = m_learned[id].find(neighbour->GetId());
+        if (learned != m_learned[id].end() &&
+            Simulator::Now() - learned->second.time < m_staleness)
+        {
+            m_hits++;
+
+            double actual = neighbour->GetHeight();
+            if ((learned->second.height <= node->GetHeight()) == (actual <= node->GetHeight()))
+                m_accurate++;
+
+            height = learned->second.height;
+            return true;
+        }
+    }
+
+    // A neighbour never heard, or not heard for too long, is left out of the queries.
+    m_unknown++;
+    return false;
+}
+
+void
+LrHeightCache::Learn(uint32_t nodeId, uint32_t neighbourId, double height, Time time)
+{
+    if (nodeId == neighbourId)
+        return;
+
+    if (nodeId >= m_learned.size())
+        m_learned.resize(nodeId + 1);
+
+    auto learned = m_learned[nodeId].find(neighbourId);
+    if (learned == m_learned[nodeId].end())
+        m_learned[nodeId][neighbourId] = {height, time};
+    else if (learned->second.time < time)
+        learned->second = {height, time};
+}
+
+void
+LrHeightCache::SnifferRx(std::string context,
+                         Ptr<const Packet> packet,
+                         uint16_t channelFreqMhz,
+                         WifiTxVector txVector,
+                         MpduInfo aMpdu,
+                         SignalNoiseDbm signalNoise,
+                         uint16_t staId)
+{
+    LrHeightTag tag;
+    if (!packet->PeekPacketTag(tag))
+        return;
+
+    // The context is /NodeList/<receiver>/DeviceList/...
+    uint32_t receiver = std::strtoul(context.c_str() + std::strlen("/NodeList/"), nullptr, 10);
+
+    for (const LrHeightTag::Entry& entry : tag.GetEntries())
+    {
+        Learn(receiver, entry.nodeId, entry.height, Simulator::Now() - MilliSeconds(entry.ageMs));
+    }
+}
+
+void
+LrHeightCache::Report() const
+{
+    NS_LOG_UNCOND("Height lookups:\t" << m_lookups);
+    NS_LOG_UNCOND("Unknown heights:\t" << (m_lookups ? double(m_unknown) / m_lookups : 0));
+    NS_LOG_UNCOND("Learned heights used:\t" << (m_lookups ? double(m_hits) / m_lookups : 0));
+    NS_LOG_UNCOND("Learned height accuracy:\t"
+                  << (m_lookups ? double(m_accurate) / m_lookups : 0));
+    NS_LOG_UNCOND("Piggybacked bytes:\t" << m_piggybackedBytes);
+    NS_LOG_UNCOND("Piggybacked bytes per packet:\t"
+                  << (m_taggedPackets ? double(m_piggybackedBytes) / m_taggedPackets : 0));
+}
@@ -0,0 +1,78 @@
+#include "../include/lr-height-tag.h"
+
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE("LrHeightTag");
+NS_OBJECT_ENSURE_REGISTERED(LrHeightTag);
+
+TypeId
+LrHeightTag::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LrHeightTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<LrHeightTag>();
+    return tid;
+}
+
+TypeId
+LrHeightTag::GetInstanceTypeId(void) const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LrHeightTag::GetSerializedSize(void) const
+{
+    return 1 + m_entries.size() * (sizeof(uint32_t) + sizeof(double) + sizeof(uint16_t));
+}
+
+void
+LrHeightTag::Serialize(TagBuffer buffer) const
+{
+    buffer.WriteU8(m_entries.size());
+    for (const Entry& entry : m_entries)
+    {
+        buffer.WriteU32(entry.nodeId);
+        buffer.WriteDouble(entry.height);
+        buffer.WriteU16(entry.ageMs);
+    }
+}
+
+void
+LrHeightTag::Deserialize(TagBuffer buffer)
+{
+    m_entries.resize(buffer.ReadU8());
+    for (Entry& entry : m_entries)
+    {
+        entry.nodeId = buffer.ReadU32();
+        entry.height = buffer.ReadDouble();
+        entry.ageMs = buffer.ReadU16();
+    }
+}
+
+void
+LrHeightTag::Print(std::ostream& os) const
+{
+    for (const Entry& entry : m_entries)
+    {
+        os << "node " << entry.nodeId << " height " << entry.height << " age " << entry.ageMs
+           << "ms ";
+    }
+}
+
+bool
+LrHeightTag::AddEntry(const Entry& entry)
+{
+    if (m_entries.size() >= MAX_ENTRIES)
+        return false;
+
+    m_entries.push_back(entry);
+    return true;
+}
+
+const std::vector<LrHeightTag::Entry>&
+LrHeightTag::GetEntries() const
+{
+    return m_entries;
+}
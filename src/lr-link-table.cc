@@ -0,0 +1,167 @@
+#include "../include/lr-link-table.h"
+
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/mobility-model.h"
+
+#include <cstdlib>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE("LrLinkTable");
+
+namespace
+{
+// Weight of the last frame in the moving average of the signal strength.
+const double RSS_SMOOTHING = 0.3;
+
+// Measurements older than this are replaced by the prediction of the loss model, the random walk
+// moves the nodes for two seconds before changing direction.
+const Time RSS_TIMEOUT = Seconds(2);
+} // namespace
+
+void
+LrLinkTable::SetThreshold(double thresholdDbm, double hysteresisDb)
+{
+    m_threshold = thresholdDbm;
+    m_hysteresis = hysteresisDb;
+}
+
+void
+LrLinkTable::SetPrediction(Ptr<PropagationLossModel> lossModel, double txPowerDbm)
+{
+    m_lossModel = lossModel;
+    m_txPower = txPowerDbm;
+}
+
+void
+LrLinkTable::AddDevice(uint32_t nodeId, Mac48Address address)
+{
+    m_devices[address] = nodeId;
+}
+
+void
+LrLinkTable::Start()
+{
+    Config::Connect("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/MonitorSnifferRx",
+                    MakeCallback(&LrLinkTable::SnifferRx, this));
+}
+
+uint64_t
+LrLinkTable::GetKey(uint32_t a, uint32_t b)
+{
+    if (a > b)
+        std::swap(a, b);
+
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+void
+LrLinkTable::SnifferRx(std::string context,
+                       Ptr<const Packet> packet,
+                       uint16_t channelFreqMhz,
+                       WifiTxVector txVector,
+                       MpduInfo aMpdu,
+                       SignalNoiseDbm signalNoise,
+                       uint16_t staId)
+{
+    // The context is /NodeList/<receiver>/DeviceList/...
+    uint32_t receiver = std::strtoul(context.c_str() + std::strlen("/NodeList/"), nullptr, 10);
+
+    WifiMacHeader header;
+    packet->PeekHeader(header);
+
+    // Only data frames carry the address of the transmitter in a known position.
+    if (!header.IsData())
+        return;
+
+    auto transmitter = m_devices.find(header.GetAddr2());
+    if (transmitter == m_devices.end() || transmitter->second == receiver)
+        return;
+
+    Link& link = m_links[GetKey(receiver, transmitter->second)];
+    link.rss = link.measured ? (1 - RSS_SMOOTHING) * link.rss + RSS_SMOOTHING * signalNoise.signal
+                             : signalNoise.signal;
+    link.heard = Simulator::Now();
+    link.measured = true;
+
+    m_measurements++;
+
+    // The state only changes with the measurements, so the neighbour queries do not depend on
+    // how often or in which order they are made.
+    bool up = IsUp(link, link.rss);
+    if (up != link.up)
+    {
+        link.up = up;
+        m_transitions++;
+    }
+}
+
+bool
+LrLinkTable::IsUp(const Link& link, double rss) const
+{
+    return link.up ? rss >= m_threshold - m_hysteresis : rss >= m_threshold;
+}
+
+bool
+LrLinkTable::IsNeighbour(Ptr<LrNode> a, Ptr<LrNode> b) const
+{
+    auto entry = m_links.find(GetKey(a->GetId(), b->GetId()));
+
+    // Only the links that have been heard are stored, so the table does not grow with the square
+    // of the nodes.
+    static const Link unknown;
+    const Link& link = (entry != m_links.end()) ? entry->second : unknown;
+
+    if (link.measured && Simulator::Now() - link.heard <= RSS_TIMEOUT)
+        return link.up;
+
+    if (!m_lossModel)
+        return link.up;
+
+    return IsUp(link,
+                m_lossModel->CalcRxPower(m_txPower,
+                                         a->GetObject<MobilityModel>(),
+                                         b->GetObject<MobilityModel>()));
+}
+
+double
+LrLinkTable::GetBreakDistance(double maxDistance) const
+{
+    if (!m_lossModel)
+        return maxDistance;
+
+    Ptr<ConstantPositionMobilityModel> from = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> to = CreateObject<ConstantPositionMobilityModel>();
+    auto isUp = [&](double distance) {
+        to->SetPosition(Vector(distance, 0, 0));
+        return m_lossModel->CalcRxPower(m_txPower, from, to) >= m_threshold - m_hysteresis;
+    };
+
+    if (isUp(maxDistance))
+        return maxDistance;
+
+    // Centimetre precision, far below the distance covered between two packets.
+    double low = 0;
+    double high = maxDistance;
+    while (high - low > 0.01)
+    {
+        double middle = (low + high) / 2;
+        if (isUp(middle))
+            low = middle;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+uint64_t
+LrLinkTable::GetTransitions() const
+{
+    return m_transitions;
+}
+
+uint64_t
+LrLinkTable::GetMeasurements() const
+{
+    return m_measurements;
+}
@@ -1,12 +1,28 @@
 #include "../include/lr-node-container.h"
 
+#include "../include/lr-engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
 NS_LOG_COMPONENT_DEFINE("LrNodeContainer");
 
+namespace
+{
+// Links expected to last longer than this many seconds are all considered equally stable,
+// otherwise every link between still nodes would tie with an infinite lifetime.
+const double NEXT_HOP_MAX_LIFETIME = 60.0;
+
+// Learned hop estimates older than this many seconds are unknown, the topology has moved on.
+const double HOP_ESTIMATE_LIFETIME = 10.0;
+} // namespace
+
 LrNodeContainer::LrNodeContainer()
     : NodeContainer(),
       Object()
 {
-    srand(time(NULL));
 }
 
 TypeId
@@ -26,28 +42,95 @@ LrNodeContainer::Get(int i)
     return NodeContainer::Get(i)->GetObject<LrNode>();
 }
 
+void
+LrNodeContainer::SetMaxRange(uint32_t maxRange)
+{
+    m_maxRange = maxRange;
+    if (m_linkTable)
+        m_breakDistance = m_linkTable->GetBreakDistance(m_maxRange);
+}
+
 void
 LrNodeContainer::Create(uint32_t n, uint32_t sinkID)
 {
-    for (uint32_t i = 0; i < n; i++)
-    {
-        double height;
+    Create(n, std::vector<uint32_t>{sinkID});
+}
 
-        if (i == sinkID)
-        {
-            height = 0.0;
-        }
-        else
+void
+LrNodeContainer::Create(uint32_t n, const std::vector<uint32_t>& sinkIDs)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_sinks.assign(n, false);
+    m_sinkIds.clear();
+    for (uint32_t sinkID : sinkIDs)
+    {
+        if (sinkID < n && !m_sinks[sinkID])
         {
-            do
-                height = rand();
-            while (m_idHeights.find(height) != m_idHeights.end());
+            m_sinks[sinkID] = true;
+            m_sinkIds.push_back(sinkID);
         }
+    }
+
+    // The heights are spread over the same range rand() used to draw from and shuffled with a
+    // Fisher-Yates pass, so they are unique by construction.
+    uint32_t others = n - m_sinkIds.size();
+    double step = static_cast<double>(RAND_MAX) / std::max(others, 1u);
+
+    std::vector<double> heights;
+    heights.reserve(others);
+    for (uint32_t i = 0; i < others; i++)
+    {
+        heights.push_back((i + 1) * step);
+    }
+
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = others; i > 1; i--)
+    {
+        std::swap(heights[i - 1], heights[random->GetInteger(0, i - 1)]);
+    }
+
+    auto heightsAssigned = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0, next = 0; i < n; i++)
+    {
+        double height = m_sinks[i] ? 0.0 : heights[next++];
 
-        m_idHeights.insert(height);
         Ptr<LrNode> node = CreateObject<LrNode>(height);
         NodeContainer::Add(node);
     }
+
+    auto nodesCreated = std::chrono::steady_clock::now();
+
+    m_heightAssignmentTime = std::chrono::duration<double>(heightsAssigned - start).count();
+    m_nodeCreationTime = std::chrono::duration<double>(nodesCreated - heightsAssigned).count();
+
+    NS_LOG_INFO("Assigned " << others << " heights in " << m_heightAssignmentTime << "s");
+    NS_LOG_INFO("Created " << n << " nodes in " << m_nodeCreationTime << "s");
+}
+
+double
+LrNodeContainer::GetHeightAssignmentTime() const
+{
+    return m_heightAssignmentTime;
+}
+
+double
+LrNodeContainer::GetNodeCreationTime() const
+{
+    return m_nodeCreationTime;
+}
+
+bool
+LrNodeContainer::IsSink(uint32_t i) const
+{
+    return i < m_sinks.size() && m_sinks[i];
+}
+
+const std::vector<uint32_t>&
+LrNodeContainer::GetSinks() const
+{
+    return m_sinkIds;
 }
 
 Ptr<LrNodeContainer>
@@ -59,7 +142,7 @@ LrNodeContainer::GetNodeNeighbours(Ptr<LrNode> node, std::function<bool(Ptr<LrNo
     {
         Ptr<LrNode> n = this->Get(i);
 
-        if (n->GetId() != node->GetId() && n->GetDistanceFrom(node) <= m_maxRange)
+        if (n->GetId() != node->GetId() && this->IsLinked(node, n))
         {
             if (filter(n))
             {
@@ -74,78 +157,287 @@ LrNodeContainer::GetNodeNeighbours(Ptr<LrNode> node, std::function<bool(Ptr<LrNo
 Ptr<LrNodeContainer>
 LrNodeContainer::GetInboundNeighbours(Ptr<LrNode> node)
 {
-    return GetNodeNeighbours(node,
-                             [node](Ptr<LrNode> n) { return n->GetHeight() > node->GetHeight(); });
+    if (m_static && !m_heightCache)
+    {
+        Ptr<LrNodeContainer> neighbours = CreateObject<LrNodeContainer>();
+        ForEachNeighbour(node, false, [&](Ptr<LrNode> n) {
+            neighbours->Add(n);
+            return true;
+        });
+        return neighbours;
+    }
+
+    return GetNodeNeighbours(node, [this, node](Ptr<LrNode> n) {
+        double height = 0;
+        return this->GetNeighbourHeight(node, n, height) && height > node->GetHeight();
+    });
 }
 
 Ptr<LrNodeContainer>
 LrNodeContainer::GetOutBoundNeighbours(Ptr<LrNode> node)
 {
-    return GetNodeNeighbours(node,
-                             [node](Ptr<LrNode> n) { return n->GetHeight() <= node->GetHeight(); });
+    if (m_static && !m_heightCache)
+    {
+        Ptr<LrNodeContainer> neighbours = CreateObject<LrNodeContainer>();
+        ForEachNeighbour(node, true, [&](Ptr<LrNode> n) {
+            neighbours->Add(n);
+            return true;
+        });
+        return neighbours;
+    }
+
+    return GetNodeNeighbours(node, [this, node](Ptr<LrNode> n) {
+        double height = 0;
+        return this->GetNeighbourHeight(node, n, height) && height <= node->GetHeight();
+    });
+}
+
+bool
+LrNodeContainer::HasOutBoundNeighbours(Ptr<LrNode> node)
+{
+    bool found = false;
+    ForEachNeighbour(node, true, [&](Ptr<LrNode>) {
+        found = true;
+        return false;
+    });
+
+    return found;
 }
 
 void
 LrNodeContainer::ReverseLink(Ptr<LrNode> node)
 {
-    Ptr<LrNodeContainer> inboundNeighbours = this->GetInboundNeighbours(node);
+    // The inbound neighbours all have a known height.
+    Ptr<LrNode> maxHeightNode = nullptr;
+    double maxHeight = 0;
+    ForEachNeighbour(node, false, [&](Ptr<LrNode> n) {
+        double height = 0;
+        this->GetNeighbourHeight(node, n, height);
+        if (!maxHeightNode || height > maxHeight)
+        {
+            maxHeightNode = n;
+            maxHeight = height;
+        }
+        return true;
+    });
 
-    if (inboundNeighbours->GetN() == 0)
+    if (!maxHeightNode)
         return;
 
-    Ptr<LrNode> maxHeightNode = inboundNeighbours->Get(0);
-    for (uint32_t i = 1; i < inboundNeighbours->GetN(); i++)
+    if (this->IsPartitioned(node))
     {
-        Ptr<LrNode> currentNode = inboundNeighbours->Get(i);
-        if (currentNode->GetHeight() > maxHeightNode->GetHeight())
-        {
-            maxHeightNode = currentNode;
-        }
+        m_suppressedReversals++;
+        return;
     }
 
-    Ptr<LrNodeContainer> inboundNeighboursMaxHeight = this->GetInboundNeighbours(maxHeightNode);
+    m_reversals++;
+    node->RecordReversal();
 
-    if (inboundNeighboursMaxHeight->GetN() == 0)
-    {
-        node->SetHeight(maxHeightNode->GetHeight() + 0.1);
-    }
-    else
+    bool maxHeightHasInbound = false;
+    double minHeight = 0;
+    ForEachNeighbour(maxHeightNode, false, [&](Ptr<LrNode> n) {
+        double height = n->GetHeight();
+        if (!maxHeightHasInbound || height < minHeight)
+            minHeight = height;
+        maxHeightHasInbound = true;
+        return true;
+    });
+
+    node->SetHeight(LrEngine::GetReversedHeight(maxHeight, maxHeightHasInbound, minHeight));
+
+    // Only the row of the reversed node and the entries pointing at it in the rows of its
+    // neighbours can change side.
+    if (m_static)
     {
-        Ptr<LrNode> minHeightNode = inboundNeighboursMaxHeight->Get(0);
-        for (uint32_t i = 1; i < inboundNeighboursMaxHeight->GetN(); i++)
+        uint32_t row = node->GetId();
+        m_staticHeights[row] = node->GetHeight();
+
+        PartitionRow(row);
+        for (uint32_t k = m_rowOffsets[row]; k < m_rowOffsets[row + 1]; k++)
         {
-            Ptr<LrNode> currentNode = inboundNeighboursMaxHeight->Get(i);
-            if (currentNode->GetHeight() < minHeightNode->GetHeight())
-            {
-                minHeightNode = currentNode;
-            }
+            PartitionRow(m_columns[k]);
         }
-
-        node->SetHeight(maxHeightNode->GetHeight() +
-                        (minHeightNode->GetHeight() - maxHeightNode->GetHeight()) / 2);
     }
 }
 
+void
+LrNodeContainer::AddAddress(Ptr<LrNode> node, Ipv4InterfaceAddress address)
+{
+    uint32_t id = node->GetId();
+    if (m_nodeAddresses.size() <= id)
+        m_nodeAddresses.resize(id + 1);
+
+    m_nodeAddresses[id].push_back(address);
+    m_addressIndex[address.GetLocal().Get()] = node;
+}
+
+void
+LrNodeContainer::RemoveAddress(Ptr<LrNode> node, Ipv4InterfaceAddress address)
+{
+    uint32_t id = node->GetId();
+    if (m_nodeAddresses.size() <= id)
+        return;
+
+    std::vector<Ipv4InterfaceAddress>& addresses = m_nodeAddresses[id];
+    addresses.erase(std::remove(addresses.begin(), addresses.end(), address), addresses.end());
+    m_addressIndex.erase(address.GetLocal().Get());
+}
+
+const std::vector<Ipv4InterfaceAddress>&
+LrNodeContainer::GetAddresses(Ptr<LrNode> node)
+{
+    static const std::vector<Ipv4InterfaceAddress> empty;
+
+    uint32_t id = node->GetId();
+    return (id < m_nodeAddresses.size()) ? m_nodeAddresses[id] : empty;
+}
+
 Ptr<LrNode>
 LrNodeContainer::GetNodeFromIPv4(Ipv4Address address)
 {
+    // The routing registers every address of its node, so an address missing from the index,
+    // like the any-address of the locally generated packets, belongs to no node.
+    if (address.IsAny())
+        return nullptr;
+
+    auto registered = m_addressIndex.find(address.Get());
+    return registered != m_addressIndex.end() ? registered->second : nullptr;
+}
+
+void
+LrNodeContainer::SetLinkTable(LrLinkTable* linkTable)
+{
+    m_linkTable = linkTable;
+    if (m_linkTable)
+        m_breakDistance = m_linkTable->GetBreakDistance(m_maxRange);
+}
+
+bool
+LrNodeContainer::IsLinked(Ptr<LrNode> a, Ptr<LrNode> b)
+{
+    if (!a->IsActive() || !b->IsActive() || a->GetDistanceFrom(b) > m_maxRange)
+        return false;
+
+    return !m_linkTable || m_linkTable->IsNeighbour(a, b);
+}
+
+void
+LrNodeContainer::SetHeightCache(LrHeightCache* heightCache)
+{
+    m_heightCache = heightCache;
+    if (!m_heightCache)
+        return;
+
+    // The nodes start with the heights of their neighbours, as after an initial round of beacons,
+    // and only the packets they overhear keep them fresh.
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> columns;
+    GetAdjacency(offsets, columns);
+
     for (uint32_t i = 0; i < this->GetN(); i++)
     {
-        Ptr<LrNode> node = this->Get(i);
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++)
+        {
+            uint32_t j = columns[k];
+            m_heightCache->Learn(i, j, this->Get(j)->GetHeight(), Simulator::Now());
+        }
+    }
+}
+
+bool
+LrNodeContainer::GetNeighbourHeight(Ptr<LrNode> node, Ptr<LrNode> neighbour, double& height)
+{
+    // The sinks never reverse, so their height is known to every node.
+    if (!m_heightCache || this->IsSink(neighbour->GetId()))
+    {
+        height = neighbour->GetHeight();
+        return true;
+    }
+
+    return m_heightCache->GetHeight(node, neighbour, height);
+}
+
+void
+LrNodeContainer::SetNextHopPolicy(NextHopPolicy policy)
+{
+    m_nextHopPolicy = policy;
+}
+
+double
+LrNodeContainer::GetDistanceToDestination(Ptr<LrNode> node, Ptr<LrNode> destination)
+{
+    if (!this->IsSink(destination->GetId()))
+        return destination->GetDistanceFrom(node);
+
+    double distance = destination->GetDistanceFrom(node);
+    for (uint32_t sinkID : m_sinkIds)
+    {
+        distance = std::min(distance, this->Get(sinkID)->GetDistanceFrom(node));
+    }
+
+    return distance;
+}
 
-        if (node->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal() == address)
-            return node;
+double
+LrNodeContainer::ScoreNextHop(Ptr<LrNode> actualNode,
+                              Ptr<LrNode> candidate,
+                              Ptr<LrNode> destination)
+{
+    switch (m_nextHopPolicy)
+    {
+    case HEIGHT:
+        return -candidate->GetHeight();
+
+    case HOPS: {
+        // The candidates are all within range of the actual node, so their distances to the
+        // destination differ by less than two ranges and one hop always outweighs them. Unknown
+        // and stale estimates lose against any known one.
+        uint32_t hops = UINT32_MAX;
+        if (candidate->GetId() < m_hopEstimates.size())
+        {
+            const HopEstimate& estimate = m_hopEstimates[candidate->GetId()];
+            if (Simulator::Now() - estimate.learned <= Seconds(HOP_ESTIMATE_LIFETIME))
+                hops = estimate.hops;
+        }
+        return -static_cast<double>(hops) * m_maxRange * 4 -
+               this->GetDistanceToDestination(candidate, destination);
     }
 
-    return nullptr;
+    case LIFETIME: {
+        double progress =
+            this->GetDistanceToDestination(actualNode, destination) -
+            this->GetDistanceToDestination(candidate, destination);
+
+        // A long-lived link must not make a step away from the destination look worse, so the
+        // backward candidates are only ranked by how little they lose and come after the others.
+        if (progress <= 0)
+            return progress;
+
+        double lifetime =
+            std::min(this->GetLinkLifetime(actualNode, candidate), NEXT_HOP_MAX_LIFETIME);
+        return progress * lifetime;
+    }
+
+    case RANDOM:
+        return m_random->GetValue();
+
+    case CONGESTION:
+        // Every queued packet costs as much as a neighbour one range further from the
+        // destination, so the traffic spills over to the other outbound neighbours as soon as
+        // the queue of the closest one starts to grow.
+        return -this->GetDistanceToDestination(candidate, destination) -
+               static_cast<double>(candidate->GetQueueLength()) * m_maxRange;
+
+    case DISTANCE:
+    default:
+        return -this->GetDistanceToDestination(candidate, destination);
+    }
 }
 
 Ptr<LrNode>
 LrNodeContainer::GetNextHop(Ptr<LrNode> actualNode, Ipv4Address source, Ipv4Address destination)
 {
-    Ptr<LrNodeContainer> outbounds = this->GetOutBoundNeighbours(actualNode);
-
-    if (outbounds->GetN() == 0)
+    if (!this->HasOutBoundNeighbours(actualNode))
         return nullptr;
 
     Ptr<LrNode> destinationNode = this->GetNodeFromIPv4(destination);
@@ -156,33 +448,361 @@ LrNodeContainer::GetNextHop(Ptr<LrNode> actualNode, Ipv4Address source, Ipv4Addr
         exit(-1);
     }
 
-    Ptr<LrNode> nextHop = outbounds->Get(0);
-    for (uint32_t i = 1; i < outbounds->GetN(); i++)
+    // The source is the previous hop, which may have sent the packet from any of its interfaces,
+    // so the nodes are compared instead of the addresses.
+    Ptr<LrNode> sourceNode = this->GetNodeFromIPv4(source);
+
+    if (m_nextHopPolicy == RANDOM && !m_random)
+        m_random = CreateObject<UniformRandomVariable>();
+
+    // With the prediction, the links about to break are only used when there is nothing else.
+    bool durableOnly = false;
+    if (m_predictionHorizon.IsStrictlyPositive())
+    {
+        ForEachNeighbour(actualNode, true, [&](Ptr<LrNode> currentNode) {
+            durableOnly = currentNode != sourceNode && this->IsDurable(actualNode, currentNode);
+            return !durableOnly;
+        });
+    }
+
+    Ptr<LrNode> nextHop = nullptr;
+    double bestScore = 0;
+    ForEachNeighbour(actualNode, true, [&](Ptr<LrNode> currentNode) {
+        if (currentNode == sourceNode)
+            return true;
+
+        // Any sink accepts the packets addressed to the sink.
+        if (currentNode == destinationNode ||
+            (this->IsSink(destinationNode->GetId()) && this->IsSink(currentNode->GetId())))
+        {
+            nextHop = currentNode;
+            return false;
+        }
+
+        if (durableOnly && !this->IsDurable(actualNode, currentNode))
+            return true;
+
+        double score = this->ScoreNextHop(actualNode, currentNode, destinationNode);
+        if (nextHop == nullptr || score > bestScore)
+        {
+            nextHop = currentNode;
+            bestScore = score;
+        }
+        return true;
+    });
+
+    return nextHop;
+}
+
+void
+LrNodeContainer::RecordHop(uint64_t packetId, Ptr<LrNode> node)
+{
+    if (m_nextHopPolicy == HOPS)
+        m_packetPaths[packetId].push_back(node->GetId());
+}
+
+void
+LrNodeContainer::RecordDelivery(uint64_t packetId)
+{
+    auto path = m_packetPaths.find(packetId);
+    if (path == m_packetPaths.end())
+        return;
+
+    m_hopEstimates.resize(this->GetN());
+
+    // The path is walked back from the last relay, which is one hop from the sink, so a node
+    // visited twice learns the hops of its last visit.
+    // The paths are bounded by the TTL, so the later visits are searched linearly.
+    const std::vector<uint32_t>& nodes = path->second;
+    for (uint32_t hops = 1; hops <= nodes.size(); hops++)
+    {
+        auto visit = nodes.end() - hops;
+        if (std::find(visit + 1, nodes.end(), *visit) == nodes.end())
+            m_hopEstimates[*visit] = {hops, Simulator::Now()};
+    }
+
+    m_packetPaths.erase(path);
+}
+
+void
+LrNodeContainer::RecordLoss(uint64_t packetId)
+{
+    auto path = m_packetPaths.find(packetId);
+    if (path == m_packetPaths.end())
+        return;
+
+    for (uint32_t nodeId : path->second)
+    {
+        if (nodeId < m_hopEstimates.size())
+            m_hopEstimates[nodeId].hops = UINT32_MAX;
+    }
+
+    m_packetPaths.erase(path);
+}
+
+void
+LrNodeContainer::GetAdjacency(std::vector<uint32_t>& offsets, std::vector<uint32_t>& columns)
+{
+    uint32_t n = this->GetN();
+    std::vector<double> x(n);
+    std::vector<double> y(n);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        Vector position = this->Get(i)->GetObject<MobilityModel>()->GetPosition();
+        x[i] = position.x;
+        y[i] = position.y;
+    }
+
+    LrEngine::BuildAdjacency(
+        x,
+        y,
+        m_maxRange,
+        [this](uint32_t i, uint32_t j, double distance) {
+            if (!this->Get(i)->IsActive() || !this->Get(j)->IsActive() || distance > m_maxRange)
+                return false;
+
+            return !m_linkTable || m_linkTable->IsNeighbour(this->Get(i), this->Get(j));
+        },
+        offsets,
+        columns);
+}
+
+bool
+LrNodeContainer::IsSinkless(uint32_t i,
+                            const std::vector<uint32_t>& offsets,
+                            const std::vector<uint32_t>& columns)
+{
+    if (this->IsSink(i) || offsets[i] == offsets[i + 1])
+        return false;
+
+    double height = this->Get(i)->GetHeight();
+    for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++)
+    {
+        if (this->Get(columns[k])->GetHeight() <= height)
+            return false;
+    }
+
+    return true;
+}
+
+uint32_t
+LrNodeContainer::ReverseSinklessNodes(uint32_t maxReversals)
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> columns;
+    GetAdjacency(offsets, columns);
+
+    // The heights are read live, so the reversals of the sweep are seen by the next checks.
+    auto isSinkless = [&](uint32_t i) {
+        return this->IsSinkless(i, offsets, columns) && !this->IsPartitioned(this->Get(i));
+    };
+
+    uint32_t n = this->GetN();
+
+    std::deque<uint32_t> pending;
+    std::vector<bool> queued(n, false);
+    for (uint32_t i = 0; i < n; i++)
     {
-        Ptr<LrNode> currentNode = outbounds->Get(i);
-        Ipv4Address currentAddress = currentNode->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+        if (isSinkless(i))
+        {
+            pending.push_back(i);
+            queued[i] = true;
+        }
+    }
+
+    uint32_t reversals = 0;
+    while (!pending.empty() && reversals < maxReversals)
+    {
+        uint32_t i = pending.front();
+        pending.pop_front();
+        queued[i] = false;
 
-        if (currentAddress == source)
+        if (!isSinkless(i))
             continue;
 
-        if (currentAddress == destination)
-            return currentNode;
+        this->ReverseLink(this->Get(i));
+        reversals++;
 
-        if (destinationNode->GetDistanceFrom(currentNode) <
-            destinationNode->GetDistanceFrom(nextHop))
+        for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++)
         {
-            nextHop = currentNode;
+            uint32_t j = columns[k];
+            if (!queued[j] && isSinkless(j))
+            {
+                pending.push_back(j);
+                queued[j] = true;
+            }
         }
     }
 
-    if (nextHop->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal() == source)
-        return nullptr;
-    else
-        return nextHop;
+    return reversals;
+}
+
+uint64_t
+LrNodeContainer::GetReversals() const
+{
+    return m_reversals;
 }
 
 void
-LrNodeContainer::SetMaxRange(uint32_t maxRange)
+LrNodeContainer::SetPrediction(Time horizon)
 {
-    m_maxRange = maxRange;
+    m_predictionHorizon = horizon;
+}
+
+double
+LrNodeContainer::GetLinkLifetime(Ptr<LrNode> a, Ptr<LrNode> b) const
+{
+    return a->GetLinkLifetime(b, m_linkTable ? m_breakDistance : m_maxRange);
+}
+
+bool
+LrNodeContainer::IsDurable(Ptr<LrNode> a, Ptr<LrNode> b) const
+{
+    double lifetime = this->GetLinkLifetime(a, b);
+    return lifetime < 0 || lifetime >= m_predictionHorizon.GetSeconds();
+}
+
+bool
+LrNodeContainer::ReverseExpiringLinks(Ptr<LrNode> node)
+{
+    if (!m_predictionHorizon.IsStrictlyPositive())
+        return false;
+
+    // A node whose neighbours keep closing in on the horizon would otherwise reverse at every
+    // packet, so it reverses pre-emptively at most once per horizon.
+    auto last = m_preemptiveTimes.find(node->GetId());
+    if (last != m_preemptiveTimes.end() && Simulator::Now() - last->second < m_predictionHorizon)
+        return false;
+
+    bool hasOutbound = false;
+    bool durable = false;
+    ForEachNeighbour(node, true, [&](Ptr<LrNode> n) {
+        hasOutbound = true;
+        durable = this->IsDurable(node, n);
+        return !durable;
+    });
+
+    if (!hasOutbound || durable)
+        return false;
+
+    // The reversal raises the node above its inbound neighbours, so the outbound links that are
+    // about to break are kept and the inbound ones become outbound as well.
+    uint64_t reversals = m_reversals;
+    this->ReverseLink(node);
+    if (m_reversals == reversals)
+        return false;
+
+    m_preemptiveReversals++;
+    m_preemptiveTimes[node->GetId()] = Simulator::Now();
+    return true;
+}
+
+uint64_t
+LrNodeContainer::GetPreemptiveReversals() const
+{
+    return m_preemptiveReversals;
+}
+
+void
+LrNodeContainer::SetPartitionDetection(Time refresh)
+{
+    m_partitionDetection = true;
+    m_partitionRefresh = refresh;
+    m_sinkComponent.clear();
+}
+
+bool
+LrNodeContainer::IsPartitioned(Ptr<LrNode> node)
+{
+    if (!m_partitionDetection || this->IsSink(node->GetId()))
+        return false;
+
+    if (m_sinkComponent.empty() || Simulator::Now() - m_partitionUpdated >= m_partitionRefresh)
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> columns;
+        GetAdjacency(offsets, columns);
+
+        m_sinkComponent.assign(this->GetN(), false);
+
+        // Every sink is a root of the DAG, a node connected to any of them is not cut off.
+        std::deque<uint32_t> frontier(m_sinkIds.begin(), m_sinkIds.end());
+        for (uint32_t sinkID : m_sinkIds)
+        {
+            m_sinkComponent[sinkID] = true;
+        }
+        while (!frontier.empty())
+        {
+            uint32_t v = frontier.front();
+            frontier.pop_front();
+
+            for (uint32_t k = offsets[v]; k < offsets[v + 1]; k++)
+            {
+                if (m_sinkComponent[columns[k]])
+                    continue;
+
+                m_sinkComponent[columns[k]] = true;
+                frontier.push_back(columns[k]);
+            }
+        }
+
+        m_partitionUpdated = Simulator::Now();
+    }
+
+    return !m_sinkComponent[node->GetId()];
+}
+
+uint64_t
+LrNodeContainer::GetSuppressedReversals() const
+{
+    return m_suppressedReversals;
+}
+
+void
+LrNodeContainer::BuildStaticAdjacency()
+{
+    uint32_t n = this->GetN();
+
+    GetAdjacency(m_rowOffsets, m_columns);
+
+    m_staticNodes.resize(n);
+    m_staticHeights.resize(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        m_staticNodes[i] = this->Get(i);
+        m_staticHeights[i] = m_staticNodes[i]->GetHeight();
+        NS_ASSERT_MSG(m_staticNodes[i]->GetId() == i, "Node IDs must match the container indexes");
+    }
+
+    m_outboundEnd.resize(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        PartitionRow(i);
+    }
+
+    m_static = true;
+
+    NS_LOG_INFO("Static adjacency built with " << m_columns.size() << " edges");
+}
+
+bool
+LrNodeContainer::IsStatic() const
+{
+    return m_static;
+}
+
+std::pair<uint32_t, uint32_t>
+LrNodeContainer::GetStaticNeighbours(uint32_t row, bool outbound) const
+{
+    if (outbound)
+        return {m_rowOffsets[row], m_outboundEnd[row]};
+
+    return {m_outboundEnd[row], m_rowOffsets[row + 1]};
+}
+
+void
+LrNodeContainer::PartitionRow(uint32_t row)
+{
+    m_outboundEnd[row] = LrEngine::PartitionRow(m_staticHeights, m_rowOffsets, m_columns, row);
 }
@@ -1,5 +1,11 @@
 #include "../include/lr-node.h"
 
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-net-device.h"
+
+#include <limits>
+
 NS_LOG_COMPONENT_DEFINE("LrNode");
 NS_OBJECT_ENSURE_REGISTERED(LrNode);
 
@@ -34,6 +40,72 @@ LrNode::SetHeight(double height)
     m_height = height;
 }
 
+uint32_t
+LrNode::GetQueueLength() const
+{
+    uint32_t packets = 0;
+
+    for (uint32_t i = 0; i < this->GetNDevices(); i++)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(this->GetDevice(i));
+        if (!device)
+            continue;
+
+        Ptr<WifiMac> mac = device->GetMac();
+        packets += mac->GetTxopQueue(mac->GetQosSupported() ? AC_BE : AC_BE_NQOS)->GetNPackets();
+    }
+
+    return packets;
+}
+
+void
+LrNode::RecordForward()
+{
+    m_forwarded++;
+}
+
+void
+LrNode::RecordReversal()
+{
+    m_reversals++;
+}
+
+void
+LrNode::AddSinklessTime(Time time)
+{
+    m_sinklessTime += time;
+}
+
+void
+LrNode::SetActive(bool active)
+{
+    m_active = active;
+}
+
+bool
+LrNode::IsActive() const
+{
+    return m_active;
+}
+
+uint64_t
+LrNode::GetForwarded() const
+{
+    return m_forwarded;
+}
+
+uint64_t
+LrNode::GetReversals() const
+{
+    return m_reversals;
+}
+
+Time
+LrNode::GetSinklessTime() const
+{
+    return m_sinklessTime;
+}
+
 Ipv4Address
 LrNode::GetIpv4Address()
 {
@@ -65,3 +137,29 @@ LrNode::GetDistanceFrom(Ptr<LrNode> node) const
 
     return -1;
 }
+
+double
+LrNode::GetLinkLifetime(Ptr<LrNode> node, double range) const
+{
+    Ptr<MobilityModel> from = this->GetObject<MobilityModel>();
+    Ptr<MobilityModel> to = node->GetObject<MobilityModel>();
+
+    if (!from || !to)
+        return -1;
+
+    Vector position = to->GetPosition() - from->GetPosition();
+    Vector velocity = to->GetVelocity() - from->GetVelocity();
+
+    // Solves |position + velocity * t| = range for the positive root.
+    double a = velocity.x * velocity.x + velocity.y * velocity.y;
+    double b = 2 * (position.x * velocity.x + position.y * velocity.y);
+    double c = position.x * position.x + position.y * position.y - range * range;
+
+    if (c > 0)
+        return 0;
+
+    if (a == 0)
+        return std::numeric_limits<double>::infinity();
+
+    return (-b + sqrt(b * b - 4 * a * c)) / (2 * a);
+}
@@ -2,6 +2,8 @@
 
 #include "../include/simulation-helper.h"
 
+#include <algorithm>
+
 NS_LOG_COMPONENT_DEFINE("LinkReversalRouting");
 NS_OBJECT_ENSURE_REGISTERED(LinkReversalRouting);
 
@@ -32,16 +34,11 @@ LinkReversalRouting::RouteOutput(Ptr<Packet> packet,
                                  Socket::SocketErrno& sockerr)
 {
     Ipv4Address destination = header.GetDestination();
-    Ptr<LrNode> actualLrNode = m_ipv4->GetObject<LrNode>();
-
-    // Here, as in RouteInput, it would be faster to retrieve the IPv4 directly from m_ipv4, but for
-    // consistency and code uniformity, I chose to do it this way.
-    Ipv4Address actualNodeIpv4 = actualLrNode->GetIpv4Address();
 
-    NS_LOG_DEBUG("Generated packet from " << actualNodeIpv4 << " to " << destination
+    NS_LOG_DEBUG("Generated packet from " << m_lrNode->GetId() << " to " << destination
                                           << " id: " << packet->GetUid());
 
-    SimulationHelper& instance = SimulationHelper::GetInstance();
+    SimulationHelper& instance = *m_helper;
 
     // When the benchmark is enabled, only a single packet is delivered.
     // So we can use a simple vector for store the times.
@@ -52,34 +49,45 @@ LinkReversalRouting::RouteOutput(Ptr<Packet> packet,
 
     // If a node have no one to forward it will try to reverse the links, but this is only tried one
     // time
-    if (instance.nodes.GetOutBoundNeighbours(actualLrNode)->GetN() == 0)
-        instance.nodes.ReverseLink(actualLrNode);
-
-    Ptr<LrNode> nextHop = instance.nodes.GetNextHop(actualLrNode, header.GetSource(), destination);
+    if (!instance.nodes.HasOutBoundNeighbours(m_lrNode))
+        instance.nodes.ReverseLink(m_lrNode);
+    else
+        instance.nodes.ReverseExpiringLinks(m_lrNode);
 
-    // This occurs when the node has no available nodes to forward the packet to, even after the
-    // link reversal process.
-    if (nextHop == nullptr)
+    // A node cut off from the sink gives up at once instead of trying its outbound neighbours.
+    if (instance.nodes.IsPartitioned(m_lrNode))
     {
         instance.m_failure++;
+        instance.m_failureStats.RecordFailure(m_lrNode->GetId(), LrFailureStats::PARTITIONED);
+        instance.packetFailed(packet);
         sockerr = Socket::ERROR_NOROUTETOHOST;
         return nullptr;
     }
 
-    Ptr<Ipv4Route> route = Create<Ipv4Route>();
-
-    route->SetDestination(destination);
-    route->SetGateway(instance.interfaces.GetAddress(nextHop->GetId()));
+    Ptr<LrNode> nextHop = instance.nodes.GetNextHop(m_lrNode, header.GetSource(), destination);
 
-    // nodes haves only one interface in addition to the loopback interface, so the value is
-    // hardcoded..
-    route->SetOutputDevice((idev != nullptr) ? idev : m_node->GetDevice(1));
+    Ptr<Ipv4Route> route;
+    if (nextHop != nullptr)
+        route = BuildRoute(nextHop, destination, idev);
 
-    route->SetSource(actualNodeIpv4);
+    // This occurs when the node has no available nodes to forward the packet to, even after the
+    // link reversal process, or when none of its interfaces reaches the next hop.
+    if (route == nullptr)
+    {
+        instance.m_failure++;
+        instance.m_failureStats.RecordFailure(m_lrNode->GetId(), LrFailureStats::NO_ROUTE_OUTPUT);
+        instance.packetFailed(packet);
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;
+    }
 
     sockerr = Socket::ERROR_NOTERROR;
 
+    if (instance.m_heightCache.IsEnabled())
+        instance.m_heightCache.TagPacket(m_lrNode, packet);
+
     instance.m_total_packet++;
+    instance.nodes.RecordHop(packet->GetUid(), m_lrNode);
 
     return route;
 }
@@ -93,20 +101,31 @@ LinkReversalRouting::RouteInput(Ptr<const Packet> packet,
                                 const LocalDeliverCallback& lcb,
                                 const ErrorCallback& ecb)
 {
-    Ptr<LrNode> actualLrNode = m_ipv4->GetObject<LrNode>();
-
     Ipv4Address destination = header.GetDestination();
-    Ipv4Address actualNodeIpv4 = actualLrNode->GetIpv4Address();
 
     uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
 
-    SimulationHelper& instance = SimulationHelper::GetInstance();
+    SimulationHelper& instance = *m_helper;
 
-    if (m_ipv4->IsDestinationAddress(destination, iif))
+    // The packets addressed to a sink are delivered by the first sink they reach, which takes
+    // them as if they were addressed to itself.
+    bool local = m_ipv4->IsDestinationAddress(destination, iif);
+    if (!local && instance.nodes.IsSink(m_lrNode->GetId()))
+    {
+        Ptr<LrNode> destinationNode = instance.nodes.GetNodeFromIPv4(destination);
+        local = destinationNode && instance.nodes.IsSink(destinationNode->GetId());
+    }
+
+    if (local)
     {
         NS_LOG_DEBUG("Packet arrived at destination " << destination
                                                       << " id: " << packet->GetUid());
-        lcb(packet, header, iif);
+
+        Ipv4Header delivered = header;
+        if (!m_ipv4->IsDestinationAddress(destination, iif))
+            delivered.SetDestination(m_ipv4->GetAddress(iif, 0).GetLocal());
+
+        lcb(packet, delivered, iif);
 
         if (instance.m_enableBenchmark == true)
         {
@@ -115,59 +134,145 @@ LinkReversalRouting::RouteInput(Ptr<const Packet> packet,
             NS_LOG_UNCOND("Elapsed time: " << elapsed.GetSeconds());
         }
 
+        // The sources send with the default TTL of 64 and every relay decrements it.
         instance.m_success++;
+        instance.m_hops += 65 - header.GetTtl();
         return true;
     }
 
-    Ptr<LrNodeContainer> outbounds = instance.nodes.GetOutBoundNeighbours(actualLrNode);
-    if (outbounds->GetN() == 0)
+    if (!instance.nodes.HasOutBoundNeighbours(m_lrNode))
     {
         NS_LOG_DEBUG("No outbound neighbours, reversing link");
-        instance.nodes.ReverseLink(actualLrNode);
+        instance.nodes.ReverseLink(m_lrNode);
+    }
+    else if (instance.nodes.ReverseExpiringLinks(m_lrNode))
+    {
+        NS_LOG_DEBUG("Outbound links about to break, reversed link");
+    }
+
+    if (instance.nodes.IsPartitioned(m_lrNode))
+    {
+        NS_LOG_DEBUG("Cut off from the sink, packet id: " << packet->GetUid());
+        instance.m_failure++;
+        instance.m_failureStats.RecordFailure(m_lrNode->GetId(), LrFailureStats::PARTITIONED);
+        instance.packetFailed(packet);
+        ecb(packet, header, Socket::ERROR_NOROUTETOHOST);
+        return false;
     }
 
-    Ptr<Ipv4Route> route = Create<Ipv4Route>();
-    Ptr<LrNode> nextHop = instance.nodes.GetNextHop(actualLrNode, header.GetSource(), destination);
+    Ptr<LrNode> nextHop = instance.nodes.GetNextHop(m_lrNode, header.GetSource(), destination);
+
+    Ptr<Ipv4Route> route;
+    if (nextHop != nullptr)
+        route = BuildRoute(nextHop, destination, nullptr);
 
     // time to live
     uint8_t ttl = header.GetTtl();
 
-    if (nextHop == nullptr)
+    if (route == nullptr)
     {
         NS_LOG_DEBUG("No route to host, packet id: " << packet->GetUid());
         instance.m_failure++;
+        instance.m_failureStats.RecordFailure(m_lrNode->GetId(), LrFailureStats::NO_ROUTE_INPUT);
+        instance.packetFailed(packet);
         ecb(packet, header, Socket::ERROR_NOROUTETOHOST);
         return false;
     }
-    else if (ttl == 0 && nextHop->GetIpv4Address() != destination)
+    else if (ttl == 0 && nextHop != instance.nodes.GetNodeFromIPv4(destination) &&
+             !instance.nodes.IsSink(nextHop->GetId()))
     {
         NS_LOG_DEBUG("TTL expired, packet id: " << packet->GetUid());
         instance.m_failure++;
+        instance.m_failureStats.RecordFailure(m_lrNode->GetId(), LrFailureStats::TTL_EXPIRED);
+        instance.packetFailed(packet);
         return false;
     }
 
-    NS_LOG_DEBUG("Forwarding packet from "
-                 << actualNodeIpv4 << " (source " << header.GetSource() << ") to "
-                 << instance.interfaces.GetAddress(nextHop->GetId()) << " ttl " << (uint32_t)ttl
-                 << " id: " << packet->GetUid());
-
-    route->SetDestination(destination);
-    route->SetGateway(instance.interfaces.GetAddress(nextHop->GetId()));
-    route->SetOutputDevice((m_ipv4->GetNetDevice(1)));
+    NS_LOG_DEBUG("Forwarding packet from " << route->GetSource() << " (source "
+                                           << header.GetSource() << ") to " << route->GetGateway()
+                                           << " ttl " << (uint32_t)ttl
+                                           << " id: " << packet->GetUid());
 
     Ipv4Header modifiedHeader = header;
-    modifiedHeader.SetSource(actualNodeIpv4);
+    modifiedHeader.SetSource(route->GetSource());
+
+    // The height of the previous hop is replaced with the one of this node.
+    Ptr<const Packet> forwarded = packet;
+    if (instance.m_heightCache.IsEnabled())
+    {
+        Ptr<Packet> tagged = packet->Copy();
+        instance.m_heightCache.TagPacket(m_lrNode, tagged);
+        forwarded = tagged;
+    }
 
-    ucb(route, packet, modifiedHeader);
+    m_lrNode->RecordForward();
+    instance.nodes.RecordHop(packet->GetUid(), m_lrNode);
+    ucb(route, forwarded, modifiedHeader);
 
     return true;
 }
 
+Ptr<Ipv4Route>
+LinkReversalRouting::BuildRoute(Ptr<LrNode> nextHop,
+                                Ipv4Address destination,
+                                Ptr<const NetDevice> oif)
+{
+    const std::vector<Ipv4InterfaceAddress>& nextHopAddresses =
+        m_helper->nodes.GetAddresses(nextHop);
+
+    for (uint32_t i = 0; i < m_interfaces.size(); i++)
+    {
+        const Interface& interface = m_interfaces[(m_nextInterface + i) % m_interfaces.size()];
+
+        if (oif != nullptr && interface.device != oif)
+            continue;
+
+        for (const Ipv4InterfaceAddress& gateway : nextHopAddresses)
+        {
+            if (!interface.address.IsInSameSubnet(gateway.GetLocal()))
+                continue;
+
+            m_nextInterface = (m_nextInterface + i + 1) % m_interfaces.size();
+
+            Ptr<Ipv4Route> route = Create<Ipv4Route>();
+            route->SetDestination(destination);
+            route->SetGateway(gateway.GetLocal());
+            route->SetOutputDevice(interface.device);
+            route->SetSource(interface.address.GetLocal());
+            return route;
+        }
+    }
+
+    return nullptr;
+}
+
+void
+LinkReversalRouting::AddInterface(uint32_t interface, Ipv4InterfaceAddress address)
+{
+    m_interfaces.push_back({interface, address, m_ipv4->GetNetDevice(interface)});
+}
+
 void
 LinkReversalRouting::SetIpv4(Ptr<Ipv4> ipv4)
 {
     NS_LOG_FUNCTION(this << ipv4);
     m_ipv4 = ipv4;
+    m_lrNode = ipv4->GetObject<LrNode>();
+    m_helper = &SimulationHelper::GetInstance();
+
+    // The interfaces configured before the protocol was installed will not be notified. The
+    // loopback interface is always the first one and it is never used to reach a neighbour.
+    m_interfaces.clear();
+    for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++)
+    {
+        for (uint32_t j = 0; j < m_ipv4->GetNAddresses(i); j++)
+        {
+            m_helper->nodes.AddAddress(m_lrNode, m_ipv4->GetAddress(i, j));
+
+            if (m_ipv4->IsUp(i))
+                AddInterface(i, m_ipv4->GetAddress(i, j));
+        }
+    }
 }
 
 void
@@ -180,24 +285,56 @@ void
 LinkReversalRouting::NotifyInterfaceUp(uint32_t interface)
 {
     NS_LOG_FUNCTION(this << interface);
+
+    if (interface == 0)
+        return;
+
+    for (uint32_t j = 0; j < m_ipv4->GetNAddresses(interface); j++)
+    {
+        AddInterface(interface, m_ipv4->GetAddress(interface, j));
+    }
 }
 
 void
 LinkReversalRouting::NotifyInterfaceDown(uint32_t interface)
 {
     NS_LOG_FUNCTION(this << interface);
+
+    m_interfaces.erase(std::remove_if(m_interfaces.begin(),
+                                      m_interfaces.end(),
+                                      [interface](const Interface& i) {
+                                          return i.index == interface;
+                                      }),
+                       m_interfaces.end());
 }
 
 void
 LinkReversalRouting::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
     NS_LOG_FUNCTION(this << interface << address);
+
+    if (interface == 0)
+        return;
+
+    m_helper->nodes.AddAddress(m_lrNode, address);
+
+    if (m_ipv4->IsUp(interface))
+        AddInterface(interface, address);
 }
 
 void
 LinkReversalRouting::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
     NS_LOG_FUNCTION(this << interface << address);
+
+    m_helper->nodes.RemoveAddress(m_lrNode, address);
+
+    m_interfaces.erase(std::remove_if(m_interfaces.begin(),
+                                      m_interfaces.end(),
+                                      [interface, address](const Interface& i) {
+                                          return i.index == interface && i.address == address;
+                                      }),
+                       m_interfaces.end());
 }
 
 void
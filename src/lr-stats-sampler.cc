@@ -0,0 +1,113 @@
+#include "../include/lr-stats-sampler.h"
+
+#include <algorithm>
+#include <cstdint>
+
+NS_LOG_COMPONENT_DEFINE("LrStatsSampler");
+
+namespace
+{
+// Size of the stream buffer of the CSV file.
+const size_t SAMPLER_BUFFER_SIZE = 1 << 20;
+} // namespace
+
+void
+LrStatsSampler::SetPacketCounters(std::function<uint64_t()> inFlight,
+                                  std::function<uint64_t()> delivered)
+{
+    m_inFlight = inFlight;
+    m_delivered = delivered;
+}
+
+bool
+LrStatsSampler::Start(LrNodeContainer* nodes, Time interval, const std::string& filename)
+{
+    m_nodes = nodes;
+    m_interval = interval;
+
+    // The buffer has to be installed before the file is opened.
+    m_buffer.resize(SAMPLER_BUFFER_SIZE);
+    m_out.rdbuf()->pubsetbuf(m_buffer.data(), m_buffer.size());
+    m_out.open(filename);
+
+    if (!m_out.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return false;
+    }
+
+    m_out << "time,reversals_per_second,mean_outbound_degree,min_outbound_degree,sinkless,"
+             "in_flight,delivered\n";
+
+    m_lastReversals = m_nodes->GetReversals();
+    m_lastTime = Simulator::Now();
+
+    Simulator::ScheduleNow(&LrStatsSampler::DoSample, this);
+    return true;
+}
+
+void
+LrStatsSampler::DoSample()
+{
+    m_nodes->GetAdjacency(m_offsets, m_columns);
+
+    uint32_t n = m_nodes->GetN();
+    std::vector<double> heights(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        heights[i] = m_nodes->Get(i)->GetHeight();
+    }
+
+    // The crashed nodes have no links, they would pin the minimum degree to zero.
+    uint64_t degrees = 0;
+    uint32_t minDegree = UINT32_MAX;
+    uint32_t sinkless = 0;
+    uint32_t counted = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (m_nodes->IsSink(i) || !m_nodes->Get(i)->IsActive())
+            continue;
+
+        uint32_t degree = 0;
+        for (uint32_t k = m_offsets[i]; k < m_offsets[i + 1]; k++)
+        {
+            if (heights[m_columns[k]] <= heights[i])
+                degree++;
+        }
+
+        counted++;
+        degrees += degree;
+        minDegree = std::min(minDegree, degree);
+        if (m_nodes->IsSinkless(i, m_offsets, m_columns))
+            sinkless++;
+    }
+
+    Time now = Simulator::Now();
+    uint64_t reversals = m_nodes->GetReversals();
+    double elapsed = (now - m_lastTime).GetSeconds();
+    double reversalRate = elapsed > 0 ? (reversals - m_lastReversals) / elapsed : 0;
+
+    m_out << now.GetSeconds() << "," << reversalRate << ","
+          << (counted > 0 ? static_cast<double>(degrees) / counted : 0) << ","
+          << (counted > 0 ? minDegree : 0) << "," << sinkless << "," << (m_inFlight ? m_inFlight() : 0)
+          << "," << (m_delivered ? m_delivered() : 0) << "\n";
+
+    m_lastReversals = reversals;
+    m_lastTime = now;
+    m_samples++;
+
+    Simulator::Schedule(m_interval, &LrStatsSampler::DoSample, this);
+}
+
+void
+LrStatsSampler::Stop()
+{
+    if (m_out.is_open())
+        m_out.close();
+}
+
+uint32_t
+LrStatsSampler::GetSamples() const
+{
+    return m_samples;
+}
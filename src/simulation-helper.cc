@@ -2,30 +2,131 @@
 
 #include "../include/lr-routing-protocol.h"
 
+#include "ns3/aodv-module.h"
+#include "ns3/dsdv-module.h"
+#include "ns3/olsr-module.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/traffic-control-layer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+// UDP port of the sink application.
+const uint16_t DATA_PORT = 9;
+} // namespace
+
 void
 SimulationHelper::setPhysicalLayer(bool enablePcap, bool enableAscii)
 {
+    // 802.11a does not aggregate the HT, VHT and HE configurations and their per-station
+    // state, which link reversal does not use, but it also changes the rates and the MAC, so it
+    // is never implied by the other options.
     WifiHelper wifi;
-    wifi.SetStandard(WIFI_STANDARD_80211ax);
+    wifi.SetStandard(this->m_wifiStandard == "a" ? WIFI_STANDARD_80211a : WIFI_STANDARD_80211ax);
 
     WifiMacHelper wifiMac;
     wifiMac.SetType("ns3::AdhocWifiMac");
 
     YansWifiPhyHelper phy;
-    YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
-    channel.AddPropagationLoss("ns3::FixedRssLossModel",
-                               "Rss",
-                               DoubleValue(-10)); // Strong constant signal
-    channel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
 
-    phy.SetChannel(channel.Create());
-    this->devices = wifi.Install(phy, wifiMac, this->nodes);
+    // Every radio gets its own channel, so the radios of a node do not interfere with each other.
+    this->measureComponent("wifi devices", [&]() {
+        for (uint32_t r = 0; r < this->m_radios; r++)
+        {
+            // The default channel already has a log-distance loss model.
+            YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
+            if (this->m_lossModel == "fixed")
+                channel.AddPropagationLoss("ns3::FixedRssLossModel",
+                                           "Rss",
+                                           DoubleValue(-10)); // Strong constant signal
+            channel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+
+            phy.SetChannel(channel.Create());
+            this->m_radioDevices.push_back(wifi.Install(phy, wifiMac, this->nodes));
+            this->devices.Add(this->m_radioDevices.back());
+        }
+    });
 
     if (enablePcap)
         phy.EnablePcapAll("lra-simulation");
 
     if (enableAscii)
         phy.EnableAsciiAll("lra-simulation");
+
+    if (this->m_rssNeighbours)
+        this->setLinkTable();
+
+    if (this->m_macStats)
+    {
+        Config::ConnectWithoutContext(
+            "/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/RemoteStationManager/MacTxDataFailed",
+            MakeCallback(&SimulationHelper::macTxDataFailed, this));
+        Config::ConnectWithoutContext(
+            "/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/RemoteStationManager/"
+            "MacTxFinalDataFailed",
+            MakeCallback(&SimulationHelper::macTxFinalDataFailed, this));
+    }
+}
+
+void
+SimulationHelper::setLinkTable()
+{
+    Ptr<PropagationLossModel> lossModel;
+    if (this->m_lossModel == "fixed")
+    {
+        lossModel = CreateObject<FixedRssLossModel>();
+        lossModel->SetAttribute("Rss", DoubleValue(-10));
+    }
+    else
+    {
+        lossModel = CreateObject<LogDistancePropagationLossModel>();
+    }
+
+    Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(this->devices.Get(0));
+
+    this->m_linkTable.SetThreshold(this->m_rssThreshold, this->m_rssHysteresis);
+    this->m_linkTable.SetPrediction(lossModel, device->GetPhy()->GetTxPowerStart());
+
+    for (uint32_t i = 0; i < this->devices.GetN(); i++)
+    {
+        Ptr<NetDevice> radio = this->devices.Get(i);
+        this->m_linkTable.AddDevice(radio->GetNode()->GetId(),
+                                    Mac48Address::ConvertFrom(radio->GetAddress()));
+    }
+
+    this->m_linkTable.Start();
+    this->nodes.SetLinkTable(&this->m_linkTable);
+}
+
+void
+SimulationHelper::macTxDataFailed(Mac48Address address)
+{
+    this->m_macRetransmissions++;
+}
+
+void
+SimulationHelper::macTxFinalDataFailed(Mac48Address address)
+{
+    this->m_macFinalFailures++;
+}
+
+void
+SimulationHelper::printMacStats() const
+{
+    NS_LOG_UNCOND("MAC retransmissions:\t" << this->m_macRetransmissions);
+    NS_LOG_UNCOND("MAC final failures:\t" << this->m_macFinalFailures);
+
+    if (this->m_rssNeighbours)
+    {
+        NS_LOG_UNCOND("Link measurements:\t" << this->m_linkTable.GetMeasurements());
+        NS_LOG_UNCOND("Link transitions:\t" << this->m_linkTable.GetTransitions());
+    }
 }
 
 void
@@ -49,38 +150,271 @@ SimulationHelper::setPhysicalEnvironment(uint32_t maxNodes)
                                   "LayoutType",
                                   StringValue("RowFirst"));
 
-    mobility.SetMobilityModel(
-        "ns3::RandomWalk2dMobilityModel",
-        "Mode",
-        StringValue("Time"),
-        "Time",
-        StringValue("2s"),
-        "Speed",
-        StringValue("ns3::ConstantRandomVariable[Constant=" + std::to_string(this->m_speed) + "]"),
-        "Bounds",
-        RectangleValue(Rectangle(0.0, gridWidth, 0.0, gridWidth)));
+    if (this->m_static)
+    {
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    }
+    else
+    {
+        mobility.SetMobilityModel(
+            "ns3::RandomWalk2dMobilityModel",
+            "Mode",
+            StringValue("Time"),
+            "Time",
+            StringValue("2s"),
+            "Speed",
+            StringValue("ns3::ConstantRandomVariable[Constant=" + std::to_string(this->m_speed) +
+                        "]"),
+            "Bounds",
+            RectangleValue(Rectangle(0.0, gridWidth, 0.0, gridWidth)));
+    }
 
-    mobility.Install(this->nodes);
+    this->measureComponent("mobility", [&]() { mobility.Install(this->nodes); });
 }
 
 void
 SimulationHelper::setNetworkLayer()
 {
-    InternetStackHelper internet;
-    internet.Install(this->nodes);
+    if (this->m_protocol != "lr")
+    {
+        // The baseline protocols are installed by the internet stack helper, the fast setup
+        // does not know them.
+        AodvHelper aodv;
+        OlsrHelper olsr;
+        DsdvHelper dsdv;
+
+        InternetStackHelper internet;
+        if (this->m_protocol == "aodv")
+            internet.SetRoutingHelper(aodv);
+        else if (this->m_protocol == "olsr")
+            internet.SetRoutingHelper(olsr);
+        else
+            internet.SetRoutingHelper(dsdv);
+
+        this->measureComponent("internet stack", [&]() { internet.Install(this->nodes); });
+    }
+    else
+    {
+        this->measureComponent("internet stack", [this]() {
+            if (this->m_fastSetup)
+            {
+                for (uint32_t i = 0; i < this->nodes.GetN(); i++)
+                {
+                    this->installFastStack(this->nodes.Get(i),
+                                           !this->m_slim || this->hasApplications(i));
+                }
+            }
+            else
+            {
+                InternetStackHelper internet;
+                internet.Install(this->nodes);
+            }
+        });
+
+        this->measureComponent("routing", [this]() {
+            for (uint32_t i = 0; i < this->nodes.GetN(); i++)
+            {
+                Ptr<LinkReversalRouting> lr = CreateObject<LinkReversalRouting>();
+                Ptr<LrNode> node = this->nodes.Get(i);
+                node->GetObject<Ipv4>()->SetRoutingProtocol(lr);
+                lr->SetNode(node);
+            }
+        });
+    }
+
+    // Each radio has its own subnet, the first one keeps the 10.1.0.0/16 addresses so the
+    // first GetN() interfaces are still indexed by node ID.
+    for (uint32_t r = 0; r < this->m_radios; r++)
+    {
+        Ipv4AddressHelper ipv4;
+        std::string base = "10." + std::to_string(r + 1) + ".0.0";
+        ipv4.SetBase(base.c_str(), "255.255.0.0");
+
+        // Assign installs the default queue discs, the slim nodes hand their packets straight
+        // to the wifi MAC queue instead.
+        this->measureComponent("addresses", [&]() {
+            this->interfaces.Add(ipv4.Assign(this->m_radioDevices[r]));
+            if (this->m_slim)
+                TrafficControlHelper().Uninstall(this->m_radioDevices[r]);
+        });
+    }
+}
+
+void
+SimulationHelper::installFastStack(Ptr<Node> node, bool udp)
+{
+    ObjectFactory factory;
+
+    for (const char* typeId : {"ns3::ArpL3Protocol",
+                               "ns3::Ipv4L3Protocol",
+                               "ns3::Icmpv4L4Protocol",
+                               "ns3::TrafficControlLayer",
+                               "ns3::UdpL4Protocol"})
+    {
+        if (!udp && std::string(typeId) == "ns3::UdpL4Protocol")
+            continue;
+
+        factory.SetTypeId(typeId);
+        node->AggregateObject(factory.Create<Object>());
+    }
+
+    // ARP sends its requests through the traffic control layer, as set by InternetStackHelper.
+    node->GetObject<ArpL3Protocol>()->SetTrafficControl(node->GetObject<TrafficControlLayer>());
+}
+
+bool
+SimulationHelper::hasApplications(uint32_t nodeId) const
+{
+    return std::find(this->m_sourceNodes.begin(), this->m_sourceNodes.end(), nodeId) !=
+               this->m_sourceNodes.end() ||
+           std::find(this->m_sinkNodes.begin(), this->m_sinkNodes.end(), nodeId) !=
+               this->m_sinkNodes.end();
+}
+
+uint64_t
+SimulationHelper::getResidentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+
+    if (!(statm >> size >> resident))
+        return 0;
+
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void
+SimulationHelper::runPhase(const std::string& name, std::function<void()> phase)
+{
+    uint64_t residentBefore = this->m_enableMemoryReport ? getResidentBytes() : 0;
+    auto start = std::chrono::steady_clock::now();
+
+    phase();
 
-    Ipv4AddressHelper ipv4;
-    ipv4.SetBase("10.1.0.0", "255.255.0.0");
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t residentAfter = this->m_enableMemoryReport ? getResidentBytes() : 0;
 
-    this->interfaces = ipv4.Assign(this->devices);
+    this->m_phases.push_back({name,
+                              elapsed.count(),
+                              static_cast<int64_t>(residentAfter) -
+                                  static_cast<int64_t>(residentBefore)});
+}
 
-    for (uint32_t i = 0; i < this->nodes.GetN(); i++)
+void
+SimulationHelper::measureComponent(const std::string& name, std::function<void()> install)
+{
+    if (!this->m_enableMemoryReport)
     {
-        Ptr<LinkReversalRouting> lr = CreateObject<LinkReversalRouting>();
-        Ptr<LrNode> node = this->nodes.Get(i);
-        node->GetObject<Ipv4>()->SetRoutingProtocol(lr);
-        lr->SetNode(node);
+        install();
+        return;
     }
+
+    uint64_t residentBefore = getResidentBytes();
+    install();
+    int64_t added = static_cast<int64_t>(getResidentBytes()) - static_cast<int64_t>(residentBefore);
+
+    // A component installed in several steps, like the addresses of each radio, is summed.
+    for (Component& component : this->m_components)
+    {
+        if (component.name == name)
+        {
+            component.residentBytes += added;
+            return;
+        }
+    }
+
+    this->m_components.push_back({name, added});
+}
+
+void
+SimulationHelper::recordFirstEvent()
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->m_setupStart;
+    this->m_firstEventTime = elapsed.count();
+}
+
+void
+SimulationHelper::printTimings() const
+{
+    for (const Phase& phase : this->m_phases)
+    {
+        NS_LOG_UNCOND("Setup " << phase.name << ":\t" << phase.seconds);
+
+        // The creation of the nodes is split between the heights and the node objects.
+        if (phase.name == "nodes")
+        {
+            NS_LOG_UNCOND("Setup nodes heights:\t" << this->nodes.GetHeightAssignmentTime());
+            NS_LOG_UNCOND("Setup nodes objects:\t" << this->nodes.GetNodeCreationTime());
+        }
+    }
+
+    NS_LOG_UNCOND("Time to first event:\t" << this->m_firstEventTime);
+    NS_LOG_UNCOND("Run time:\t" << this->m_runTime);
+    NS_LOG_UNCOND("Events executed:\t" << this->m_events);
+    NS_LOG_UNCOND("Events per second:\t"
+                  << (this->m_runTime > 0 ? this->m_events / this->m_runTime : 0));
+    NS_LOG_UNCOND("Simulated seconds per second:\t"
+                  << (this->m_runTime > 0 ? this->m_simulatedTime / this->m_runTime : 0));
+}
+
+void
+SimulationHelper::printMemory() const
+{
+    int64_t total = 0;
+    for (const Phase& phase : this->m_phases)
+    {
+        total += phase.residentBytes;
+    }
+
+    // The setup work outside the components, like the traces and the link table, is left over.
+    int64_t other = total;
+    for (const Component& component : this->m_components)
+    {
+        NS_LOG_UNCOND("Memory " << component.name << ":\t"
+                                << static_cast<double>(component.residentBytes) / this->m_maxNodes
+                                << " bytes/node");
+        other -= component.residentBytes;
+    }
+
+    NS_LOG_UNCOND("Memory other:\t" << static_cast<double>(other) / this->m_maxNodes
+                                    << " bytes/node");
+    NS_LOG_UNCOND("Bytes per node:\t" << static_cast<double>(total) / this->m_maxNodes);
+}
+
+void
+SimulationHelper::runMaintenance()
+{
+    auto start = std::chrono::steady_clock::now();
+    uint32_t reversals = this->nodes.ReverseSinklessNodes(this->nodes.GetN());
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    this->m_maintenanceSweeps++;
+    this->m_maintenanceReversals += reversals;
+    this->m_maintenanceTime += elapsed.count();
+
+    Simulator::Schedule(Seconds(this->m_maintenanceInterval),
+                        &SimulationHelper::runMaintenance,
+                        this);
+}
+
+void
+SimulationHelper::printMaintenance() const
+{
+    NS_LOG_UNCOND("Maintenance sweeps:\t" << this->m_maintenanceSweeps);
+    NS_LOG_UNCOND("Maintenance reversals:\t" << this->m_maintenanceReversals);
+    NS_LOG_UNCOND("Maintenance time:\t" << this->m_maintenanceTime);
+    NS_LOG_UNCOND("Total reversals:\t" << this->nodes.GetReversals());
+}
+
+void
+SimulationHelper::saveCheckpoint()
+{
+    LrCheckpoint checkpoint;
+    checkpoint.Capture(this->nodes, this->m_sourceNodeId);
+
+    if (!checkpoint.Save(this->m_checkpointFile))
+        NS_LOG_UNCOND("Unable to save the checkpoint " << this->m_checkpointFile);
 }
 
 void
@@ -103,9 +437,141 @@ SimulationHelper::parseCLI(int argc, char* argv[])
     cmd.AddValue("benchmark",
                  "Execute benchmarks and output result in a file",
                  this->m_enableBenchmark);
+    cmd.AddValue("monitor",
+                 "Periodically check the convergence of the DAG towards the sink",
+                 this->m_enableMonitor);
+    cmd.AddValue("monitor-interval",
+                 "Interval in seconds between two DAG samples",
+                 this->m_monitorInterval);
+    cmd.AddValue("monitor-file", "Write the DAG samples to a CSV file", this->m_monitorFile);
+    cmd.AddValue("timing",
+                 "Report the wall-clock time of each setup phase",
+                 this->m_enableTiming);
+    cmd.AddValue("fast-setup",
+                 "Install only the network components needed by link reversal",
+                 this->m_fastSetup);
+    cmd.AddValue("memory-report",
+                 "Report the resident memory per node added by each component",
+                 this->m_enableMemoryReport);
+    cmd.AddValue("slim",
+                 "Install UDP only on the sources and sinks and no queue discs, implies "
+                 "--fast-setup",
+                 this->m_slim);
+    cmd.AddValue("wifi-standard", "Wifi standard of the radios: ax or a", this->m_wifiStandard);
+    cmd.AddValue("checkpoint-at",
+                 "Save a checkpoint of the nodes at this time in seconds",
+                 this->m_checkpointAt);
+    cmd.AddValue("checkpoint-file", "File where the checkpoint is saved", this->m_checkpointFile);
+    cmd.AddValue("restore", "Start the simulation from a checkpoint file", this->m_restoreFile);
+    cmd.AddValue("static",
+                 "Keep the nodes still and precompute their adjacency",
+                 this->m_static);
+    cmd.AddValue("radios", "Number of wifi interfaces of each node", this->m_radios);
+    cmd.AddValue("proactive",
+                 "Periodically reverse the sink-less nodes in the background",
+                 this->m_proactive);
+    cmd.AddValue("maintenance-interval",
+                 "Interval in seconds between two proactive maintenance sweeps",
+                 this->m_maintenanceInterval);
+
+    cmd.AddValue("rss-neighbours",
+                 "Decide the neighbours from the signal strength measured by the radios",
+                 this->m_rssNeighbours);
+    cmd.AddValue("rss-threshold",
+                 "Signal strength in dBm at which a link comes up",
+                 this->m_rssThreshold);
+    cmd.AddValue("rss-hysteresis",
+                 "Margin in dB below the threshold at which a link goes down",
+                 this->m_rssHysteresis);
+    cmd.AddValue("loss-model", "Propagation loss model: fixed or logdistance", this->m_lossModel);
+    cmd.AddValue("mac-stats", "Report the MAC retransmissions and drops", this->m_macStats);
+    cmd.AddValue("protocol", "Routing protocol: lr, aodv, olsr or dsdv", this->m_protocol);
+    cmd.AddValue("sinks",
+                 "Comma-separated IDs of additional sinks sharing the traffic of the sink",
+                 this->m_sinksSpec);
+    cmd.AddValue("flows", "Number of sources sending packets to the sink", this->m_flows);
+    cmd.AddValue("interval",
+                 "Interval in seconds between two packets of a source",
+                 this->m_interval);
+    cmd.AddValue("sample-interval",
+                 "Interval in seconds between two samples of the routing state",
+                 this->m_sampleInterval);
+    cmd.AddValue("sample-file",
+                 "Stream samples of the routing state to a CSV file",
+                 this->m_sampleFile);
+    cmd.AddValue("heatmap-file",
+                 "Write the per-node load binned on a grid to a CSV or PGM file",
+                 this->m_heatmapFile);
+    cmd.AddValue("heatmap-bins", "Number of bins on each side of the heatmap", this->m_heatmapBins);
+    cmd.AddValue("heatmap-interval",
+                 "Interval in seconds between two samples of the sink-less nodes",
+                 this->m_heatmapInterval);
+    cmd.AddValue("failure-report",
+                 "Report the failures by cause, including the MAC drops",
+                 this->m_failureReport);
+    cmd.AddValue("hotspots",
+                 "Report the given number of nodes with the most failures",
+                 this->m_hotspots);
+    cmd.AddValue("next-hop",
+                 "Next hop policy: distance, height, hops, lifetime, random or congestion",
+                 this->m_nextHop);
+    cmd.AddValue("scheduler",
+                 "Event scheduler: map, heap, list, calendar or priority",
+                 this->m_scheduler);
+    cmd.AddValue("predictive",
+                 "Reverse the nodes whose outbound links are all about to break",
+                 this->m_predictive);
+    cmd.AddValue("prediction-horizon",
+                 "Predicted lifetime in seconds below which a link is about to break",
+                 this->m_predictionHorizon);
+    cmd.AddValue("learned-heights",
+                 "Route with the heights learned from the overheard packets",
+                 this->m_learnedHeights);
+    cmd.AddValue("height-staleness",
+                 "Age in seconds beyond which a learned height is no longer used",
+                 this->m_heightStaleness);
+    cmd.AddValue("partition-detection",
+                 "Drop packets and stop reversals in partitions cut off from the sink",
+                 this->m_partitionDetection);
+    cmd.AddValue("partition-interval",
+                 "Maximum age in seconds of the component of the sink",
+                 this->m_partitionInterval);
+    cmd.AddValue("fail",
+                 "Crash nodes at given times, as a list of ID:T[:D] (rejoin after D seconds)",
+                 this->m_failSpec);
+    cmd.AddValue("churn-rate",
+                 "Mean number of random node crashes per second",
+                 this->m_churnRate);
+    cmd.AddValue("churn-downtime",
+                 "Seconds before a randomly crashed node rejoins, 0 to never rejoin",
+                 this->m_churnDowntime);
 
     cmd.Parse(argc, argv);
 
+    // The checkpoint decides the size of the network and the role of the nodes, and its seed
+    // has to be set before any random variable is created.
+    if (!this->m_restoreFile.empty())
+    {
+        if (!this->m_checkpoint.Load(this->m_restoreFile))
+        {
+            NS_LOG_UNCOND("Unable to restore the checkpoint " << this->m_restoreFile);
+            exit(0);
+        }
+
+        this->m_maxNodes = this->m_checkpoint.GetN();
+        this->m_sinkNodeId = this->m_checkpoint.GetSinkIds().front();
+        this->m_sourceNodeId = this->m_checkpoint.GetSourceId();
+        RngSeedManager::SetSeed(this->m_checkpoint.GetSeed());
+
+        // The simulated time restarts from 0, only the state of the nodes is carried over.
+        NS_LOG_UNCOND("Restored checkpoint taken at:\t"
+                      << this->m_checkpoint.GetTime().GetSeconds());
+
+        if (this->m_checkpoint.GetRun() != RngSeedManager::GetRun())
+            NS_LOG_UNCOND("Warning: the checkpoint was taken with --RngRun="
+                          << this->m_checkpoint.GetRun() << ", this run draws other random values");
+    }
+
     if (this->m_sinkNodeId >= this->m_maxNodes || this->m_sourceNodeId >= this->m_maxNodes)
     {
         NS_LOG_UNCOND("Node ID must be less than the number of nodes");
@@ -142,40 +608,432 @@ SimulationHelper::parseCLI(int argc, char* argv[])
         exit(0);
     }
 
-    if (this->m_simulationDuration < this->m_maxPackets)
+    if (this->m_monitorInterval <= 0)
+    {
+        NS_LOG_UNCOND("Monitor interval must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_sampleInterval <= 0)
+    {
+        NS_LOG_UNCOND("Sample interval must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_heatmapBins == 0 || this->m_heatmapInterval <= 0)
+    {
+        NS_LOG_UNCOND("Heatmap bins and interval must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_radios == 0 || this->m_radios > 254)
+    {
+        NS_LOG_UNCOND("Radios must be between 1 and 254");
+        exit(0);
+    }
+
+    if (this->m_checkpointAt < 0 || this->m_checkpointAt >= this->m_simulationDuration)
+    {
+        NS_LOG_UNCOND("Checkpoint time must be between 0 and the simulation duration");
+        exit(0);
+    }
+
+    if (this->m_maintenanceInterval <= 0)
+    {
+        NS_LOG_UNCOND("Maintenance interval must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_wifiStandard != "ax" && this->m_wifiStandard != "a")
+    {
+        NS_LOG_UNCOND("Wifi standard must be ax or a");
+        exit(0);
+    }
+
+    if (this->m_lossModel != "fixed" && this->m_lossModel != "logdistance")
+    {
+        NS_LOG_UNCOND("Loss model must be fixed or logdistance");
+        exit(0);
+    }
+
+    // The fixed loss model gives every pair the same signal strength, which says nothing about
+    // the links.
+    if (this->m_rssNeighbours && this->m_lossModel != "logdistance")
+    {
+        NS_LOG_UNCOND("RSS neighbours require the logdistance loss model");
+        exit(0);
+    }
+
+    if (this->m_rssHysteresis < 0)
+    {
+        NS_LOG_UNCOND("RSS hysteresis must be positive");
+        exit(0);
+    }
+
+    const std::map<std::string, LrNodeContainer::NextHopPolicy> policies = {
+        {"distance", LrNodeContainer::DISTANCE},
+        {"height", LrNodeContainer::HEIGHT},
+        {"hops", LrNodeContainer::HOPS},
+        {"lifetime", LrNodeContainer::LIFETIME},
+        {"random", LrNodeContainer::RANDOM},
+        {"congestion", LrNodeContainer::CONGESTION}};
+
+    auto policy = policies.find(this->m_nextHop);
+    if (policy == policies.end())
+    {
+        NS_LOG_UNCOND("Next hop policy must be distance, height, hops, lifetime, random or "
+                      "congestion");
+        exit(0);
+    }
+    this->m_nextHopPolicy = policy->second;
+
+    if (this->m_slim)
+        this->m_fastSetup = true;
+
+    const std::map<std::string, std::string> schedulers = {
+        {"map", "ns3::MapScheduler"},
+        {"heap", "ns3::HeapScheduler"},
+        {"list", "ns3::ListScheduler"},
+        {"calendar", "ns3::CalendarScheduler"},
+        {"priority", "ns3::PriorityQueueScheduler"}};
+
+    auto scheduler = schedulers.find(this->m_scheduler);
+    if (scheduler == schedulers.end())
+    {
+        NS_LOG_UNCOND("Scheduler must be map, heap, list, calendar or priority");
+        exit(0);
+    }
+    this->m_schedulerType = scheduler->second;
+
+    if (this->m_protocol != "lr" && this->m_protocol != "aodv" && this->m_protocol != "olsr" &&
+        this->m_protocol != "dsdv")
+    {
+        NS_LOG_UNCOND("Protocol must be lr, aodv, olsr or dsdv");
+        exit(0);
+    }
+
+    if (this->m_predictionHorizon <= 0)
+    {
+        NS_LOG_UNCOND("Prediction horizon must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_heightStaleness <= 0)
+    {
+        NS_LOG_UNCOND("Height staleness must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_partitionInterval <= 0)
+    {
+        NS_LOG_UNCOND("Partition interval must be greater than 0");
+        exit(0);
+    }
+
+    if (!this->m_churn.AddFailures(this->m_failSpec))
+    {
+        NS_LOG_UNCOND("Failures must be a comma-separated list of ID:T[:D]");
+        exit(0);
+    }
+
+    if (this->m_churnRate < 0 || this->m_churnDowntime < 0)
+    {
+        NS_LOG_UNCOND("Churn rate and downtime must be positive");
+        exit(0);
+    }
+    this->m_churn.SetChurn(this->m_churnRate, Seconds(this->m_churnDowntime));
+
+    if (this->m_interval <= 0)
+    {
+        NS_LOG_UNCOND("Interval must be greater than 0");
+        exit(0);
+    }
+
+    if (this->m_flows == 0 || this->m_flows >= this->m_maxNodes)
     {
-        NS_LOG_UNCOND("Duration must be greater than the number of packets ~(1 packets/second)");
-        this->m_maxPackets = this->m_simulationDuration;
+        NS_LOG_UNCOND("Flows must be between 1 and the number of nodes minus 1");
+        exit(0);
+    }
+
+    if (this->m_simulationDuration < this->m_maxPackets * this->m_interval)
+    {
+        NS_LOG_UNCOND("Duration must be greater than the number of packets ~(1 packets/interval)");
+        this->m_maxPackets = static_cast<uint32_t>(this->m_simulationDuration / this->m_interval);
     }
 
+    // Drawn from an ns-3 stream, so the sink only depends on --RngSeed and --RngRun.
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
     while (this->m_sourceNodeId == this->m_sinkNodeId)
     {
-        this->m_sinkNodeId = rand() % this->m_maxNodes;
+        this->m_sinkNodeId = random->GetInteger(0, this->m_maxNodes - 1);
     };
+
+    // A restored simulation keeps the gateways of the checkpoint, --sinks can only add to them.
+    this->m_sinkNodes = {this->m_sinkNodeId};
+    if (!this->m_restoreFile.empty())
+        this->m_sinkNodes = this->m_checkpoint.GetSinkIds();
+
+    std::stringstream sinks(this->m_sinksSpec);
+    std::string sink;
+    while (std::getline(sinks, sink, ','))
+    {
+        char* end = nullptr;
+        unsigned long id = std::strtoul(sink.c_str(), &end, 10);
+        if (sink.empty() || *end != '\0' || id >= this->m_maxNodes || id == this->m_sourceNodeId)
+        {
+            NS_LOG_UNCOND("Sinks must be a list of node IDs, different from the source");
+            exit(0);
+        }
+
+        if (std::find(this->m_sinkNodes.begin(), this->m_sinkNodes.end(), id) ==
+            this->m_sinkNodes.end())
+            this->m_sinkNodes.push_back(id);
+    }
+
+    if (this->m_sinkNodes.size() > 1 && this->m_protocol != "lr")
+    {
+        NS_LOG_UNCOND("Multiple sinks are only supported by link reversal");
+        exit(0);
+    }
+
+    if (this->m_flows + this->m_sinkNodes.size() > this->m_maxNodes)
+    {
+        NS_LOG_UNCOND("Flows and sinks must not exceed the number of nodes");
+        exit(0);
+    }
+
+    // The additional sources are drawn after the sink, so a single flow keeps the same sink.
+    this->m_sourceNodes = {this->m_sourceNodeId};
+    while (this->m_sourceNodes.size() < this->m_flows)
+    {
+        uint32_t source = random->GetInteger(0, this->m_maxNodes - 1);
+        if (std::find(this->m_sinkNodes.begin(), this->m_sinkNodes.end(), source) ==
+                this->m_sinkNodes.end() &&
+            std::find(this->m_sourceNodes.begin(), this->m_sourceNodes.end(), source) ==
+                this->m_sourceNodes.end())
+            this->m_sourceNodes.push_back(source);
+    }
+
+    if (!this->m_churn.Validate(this->m_maxNodes, this->m_sinkNodes))
+    {
+        NS_LOG_UNCOND("Failed nodes must exist and differ from the sinks");
+        exit(0);
+    }
+
+    // The recoveries end on the deliveries of the flows whose packets link reversal dropped,
+    // the baseline protocols do not report their drops.
+    if (this->m_churn.IsEnabled() && this->m_protocol != "lr")
+    {
+        NS_LOG_UNCOND("Node churn is only supported by link reversal");
+        exit(0);
+    }
+
+    // The slim nodes are a reduced fast setup, which the other protocols do not use.
+    if (this->m_slim && this->m_protocol != "lr")
+    {
+        NS_LOG_UNCOND("The slim nodes are only supported by link reversal");
+        exit(0);
+    }
 }
 
 void
 SimulationHelper::setApplicationLayer()
 {
-    uint16_t port = 9;
+    uint16_t port = DATA_PORT;
 
     Address sinkAddress(InetSocketAddress(interfaces.GetAddress(this->m_sinkNodeId), port));
     PacketSinkHelper packetSinkHelper("ns3::UdpSocketFactory", sinkAddress);
     ApplicationContainer sinkApps = packetSinkHelper.Install(nodes.Get(this->m_sinkNodeId));
 
-    sinkApps.Start(Seconds(0));
-    sinkApps.Stop(Seconds(this->m_simulationDuration));
-
     UdpClientHelper udpClient(sinkAddress);
 
     udpClient.SetAttribute("MaxPackets", UintegerValue(this->m_maxPackets));
-    udpClient.SetAttribute("Interval", TimeValue(Seconds(1.0)));
+    udpClient.SetAttribute("Interval", TimeValue(Seconds(this->m_interval)));
     udpClient.SetAttribute("PacketSize", UintegerValue(1024));
 
-    ApplicationContainer clientApps = udpClient.Install(this->nodes.Get(this->m_sourceNodeId));
+    ApplicationContainer clientApps;
+    for (uint32_t source : this->m_sourceNodes)
+    {
+        clientApps.Add(udpClient.Install(this->nodes.Get(source)));
+    }
 
     clientApps.Start(Seconds(0.0));
     clientApps.Stop(Seconds(this->m_simulationDuration));
+
+    for (uint32_t i = 0; i < clientApps.GetN(); i++)
+    {
+        clientApps.Get(i)->TraceConnectWithoutContext(
+            "Tx",
+            MakeCallback(&SimulationHelper::packetSent, this));
+    }
+    // The other sinks accept the packets addressed to the sink, whatever their destination.
+    PacketSinkHelper anycastSinkHelper("ns3::UdpSocketFactory",
+                                       InetSocketAddress(Ipv4Address::GetAny(), port));
+    for (uint32_t i = 1; i < this->m_sinkNodes.size(); i++)
+    {
+        sinkApps.Add(anycastSinkHelper.Install(nodes.Get(this->m_sinkNodes[i])));
+    }
+
+    sinkApps.Start(Seconds(0));
+    sinkApps.Stop(Seconds(this->m_simulationDuration));
+
+    for (uint32_t i = 0; i < sinkApps.GetN(); i++)
+    {
+        sinkApps.Get(i)->TraceConnectWithoutContext(
+            "Rx",
+            MakeCallback(&SimulationHelper::packetReceived, this));
+    }
+}
+
+void
+SimulationHelper::packetSent(Ptr<const Packet> packet)
+{
+    // The applications run in the context of their node, so the context is the source of the
+    // flow.
+    this->m_packetsSent++;
+    this->m_sentPackets[packet->GetUid()] = {Simulator::Now(), Simulator::GetContext()};
+}
+
+void
+SimulationHelper::packetReceived(Ptr<const Packet> packet, const Address& from)
+{
+    auto sent = this->m_sentPackets.find(packet->GetUid());
+    if (sent == this->m_sentPackets.end())
+        return;
+
+    this->m_deliveryTimes.push_back((Simulator::Now() - sent->second.time).GetSeconds());
+    this->m_receivedBytes += packet->GetSize();
+    this->m_churn.RecordDelivery(sent->second.source);
+    this->nodes.RecordDelivery(packet->GetUid());
+    this->m_sentPackets.erase(sent);
+}
+
+void
+SimulationHelper::packetFailed(Ptr<const Packet> packet)
+{
+    auto sent = this->m_sentPackets.find(packet->GetUid());
+    if (sent == this->m_sentPackets.end())
+        return;
+
+    this->m_failureLatencies.push_back((Simulator::Now() - sent->second.time).GetSeconds());
+    this->m_churn.RecordFailure(sent->second.source);
+    this->nodes.RecordLoss(packet->GetUid());
+    this->m_sentPackets.erase(sent);
+}
+
+void
+SimulationHelper::printPartitions() const
+{
+    double latency = 0;
+    for (double failureLatency : this->m_failureLatencies)
+    {
+        latency += failureLatency;
+    }
+
+    if (!this->m_failureLatencies.empty())
+        latency /= this->m_failureLatencies.size();
+
+    NS_LOG_UNCOND("Partition drops:\t"
+                  << this->m_failureStats.GetFailures(LrFailureStats::PARTITIONED));
+    NS_LOG_UNCOND("Reversals saved:\t" << this->nodes.GetSuppressedReversals());
+    NS_LOG_UNCOND("Mean failure latency:\t" << latency);
+}
+
+double
+SimulationHelper::getDeliveryTimePercentile(double percentile) const
+{
+    if (this->m_deliveryTimes.empty())
+        return 0;
+
+    std::vector<double> sorted = this->m_deliveryTimes;
+    uint32_t rank = std::ceil(percentile / 100 * sorted.size());
+    rank = std::min<uint32_t>(std::max<uint32_t>(rank, 1), sorted.size());
+
+    std::nth_element(sorted.begin(), sorted.begin() + rank - 1, sorted.end());
+    return sorted[rank - 1];
+}
+
+void
+SimulationHelper::ipv4Tx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    Ptr<Packet> copy = packet->Copy();
+    Ipv4Header ipHeader;
+    copy->RemoveHeader(ipHeader);
+
+    if (ipHeader.GetProtocol() != UdpL4Protocol::PROT_NUMBER)
+        return;
+
+    // Everything that is not addressed to the port of the sink is routing traffic.
+    UdpHeader udpHeader;
+    copy->PeekHeader(udpHeader);
+    if (udpHeader.GetDestinationPort() == DATA_PORT)
+        return;
+
+    this->m_controlPackets++;
+    this->m_controlBytes += packet->GetSize();
+}
+
+double
+SimulationHelper::getDeliveryRatio() const
+{
+    if (this->m_packetsSent == 0)
+        return 0;
+
+    return static_cast<double>(this->m_deliveryTimes.size()) / this->m_packetsSent;
+}
+
+bool
+SimulationHelper::hasControlPackets() const
+{
+    return this->m_protocol != "lr";
+}
+
+uint64_t
+SimulationHelper::getControlPackets() const
+{
+    return this->m_controlPackets;
+}
+
+uint64_t
+SimulationHelper::getControlBytes() const
+{
+    return this->m_controlBytes;
+}
+
+double
+SimulationHelper::getWallClockTime() const
+{
+    return this->m_wallClockTime;
+}
+
+double
+SimulationHelper::getMeanHopCount() const
+{
+    if (this->m_success == 0)
+        return 0;
+
+    return static_cast<double>(this->m_hops) / this->m_success;
+}
+
+double
+SimulationHelper::getThroughput() const
+{
+    return this->m_receivedBytes * 8.0 / 1000 / this->m_simulationDuration;
+}
+
+double
+SimulationHelper::getMeanDeliveryTime() const
+{
+    if (this->m_deliveryTimes.empty())
+        return 0;
+
+    double total = 0;
+    for (double deliveryTime : this->m_deliveryTimes)
+    {
+        total += deliveryTime;
+    }
+
+    return total / this->m_deliveryTimes.size();
 }
 
 void
@@ -185,16 +1043,166 @@ SimulationHelper::startSimulation()
     NS_LOG_UNCOND("Source node id:\t" << this->m_sourceNodeId);
     NS_LOG_UNCOND("Sink node id:\t" << this->m_sinkNodeId);
 
+    this->m_setupStart = std::chrono::steady_clock::now();
+
+    // Set before the first event is scheduled, so no event has to be moved between schedulers.
+    ObjectFactory scheduler;
+    scheduler.SetTypeId(this->m_schedulerType);
+    Simulator::SetScheduler(scheduler);
+
     this->nodes.SetMaxRange(this->m_maxRange);
-    this->nodes.Create(this->m_maxNodes, this->m_sinkNodeId);
+    this->nodes.SetNextHopPolicy(this->m_nextHopPolicy);
+
+    if (this->m_predictive)
+        this->nodes.SetPrediction(Seconds(this->m_predictionHorizon));
 
-    this->setPhysicalLayer(this->m_enablePcap, this->m_enableAscii);
-    this->setPhysicalEnvironment(this->m_maxNodes);
-    this->setNetworkLayer();
-    this->setApplicationLayer();
+    if (this->m_partitionDetection)
+        this->nodes.SetPartitionDetection(Seconds(this->m_partitionInterval));
+
+    this->runPhase("nodes", [this]() {
+        this->measureComponent("nodes", [this]() {
+            this->nodes.Create(this->m_maxNodes, this->m_sinkNodes);
+        });
+    });
+    this->runPhase("physical layer",
+                   [this]() { this->setPhysicalLayer(this->m_enablePcap, this->m_enableAscii); });
+    this->runPhase("physical environment",
+                   [this]() { this->setPhysicalEnvironment(this->m_maxNodes); });
+
+    if (!this->m_restoreFile.empty())
+        this->runPhase("restore", [this]() { this->m_checkpoint.Apply(this->nodes); });
+
+    // A speed of zero does not move the random walk, so the topology never changes either way,
+    // unless the links follow the measured signal strength, which changes without any movement.
+    if ((this->m_static || this->m_speed == 0) && !this->m_rssNeighbours)
+        this->runPhase("static adjacency", [this]() { this->nodes.BuildStaticAdjacency(); });
+
+    this->runPhase("network layer", [this]() { this->setNetworkLayer(); });
+
+    // Link reversal sends no control packets, the heights are read by the other nodes directly.
+    if (this->m_protocol != "lr")
+        Config::ConnectWithoutContext("/NodeList/*/$ns3::Ipv4L3Protocol/Tx",
+                                      MakeCallback(&SimulationHelper::ipv4Tx, this));
+
+    if (this->m_learnedHeights && this->m_protocol == "lr")
+    {
+        this->m_heightCache.Start(Seconds(this->m_heightStaleness));
+        this->nodes.SetHeightCache(&this->m_heightCache);
+    }
+
+    this->runPhase("application layer", [this]() {
+        this->measureComponent("applications", [this]() { this->setApplicationLayer(); });
+    });
+
+    if (this->m_enableTiming)
+        Simulator::ScheduleNow(&SimulationHelper::recordFirstEvent, this);
+
+    if (this->m_checkpointAt > 0)
+        Simulator::Schedule(Seconds(this->m_checkpointAt), &SimulationHelper::saveCheckpoint, this);
+
+    if (this->m_proactive)
+        Simulator::Schedule(Seconds(this->m_maintenanceInterval),
+                            &SimulationHelper::runMaintenance,
+                            this);
+
+    // The sampler needs the MAC drops too, the packets dropped by the MAC are no longer in flight.
+    if (this->m_failureReport || this->m_hotspots > 0 || !this->m_sampleFile.empty())
+        this->m_failureStats.Start(DATA_PORT);
+
+    if (!this->m_sampleFile.empty())
+    {
+        this->m_statsSampler.SetPacketCounters(
+            [this]() {
+                uint64_t done = this->m_success + this->m_failure +
+                                this->m_failureStats.GetMacDrops();
+                return this->m_packetsSent > done ? this->m_packetsSent - done : 0;
+            },
+            [this]() { return static_cast<uint64_t>(this->m_success); });
+
+        if (!this->m_statsSampler.Start(&this->nodes,
+                                        Seconds(this->m_sampleInterval),
+                                        this->m_sampleFile))
+            NS_LOG_UNCOND("Unable to open the sample file " << this->m_sampleFile);
+    }
+
+    if (!this->m_heatmapFile.empty())
+        this->m_heatmap.Start(&this->nodes, Seconds(this->m_heatmapInterval));
+
+    if (this->m_churn.IsEnabled())
+        this->m_churn.Start(&this->nodes);
+
+    if (this->m_enableMonitor)
+        this->m_dagMonitor.Start(&this->nodes, Seconds(this->m_monitorInterval));
 
     Simulator::Stop(Seconds(this->m_simulationDuration));
+
+    auto runStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    auto runEnd = std::chrono::steady_clock::now();
+
+    this->m_runTime = std::chrono::duration<double>(runEnd - runStart).count();
+    this->m_events = Simulator::GetEventCount();
+    this->m_simulatedTime = Simulator::Now().GetSeconds();
+
+    std::chrono::duration<double> wallClock = runEnd - this->m_setupStart;
+    this->m_wallClockTime = wallClock.count();
+
+    // The baseline protocols do not update the counters of link reversal, the application
+    // traces are used instead.
+    if (this->m_protocol != "lr")
+    {
+        this->m_success = this->m_deliveryTimes.size();
+        this->m_failure = this->m_packetsSent - this->m_deliveryTimes.size();
+    }
+
+    this->m_statsSampler.Stop();
+
+    if (this->m_enableTiming)
+        this->printTimings();
+
+    if (this->m_enableMemoryReport)
+        this->printMemory();
+
+    if (this->m_proactive)
+        this->printMaintenance();
+
+    if (this->m_macStats)
+        this->printMacStats();
+
+    if (!this->m_heatmapFile.empty() &&
+        !this->m_heatmap.Write(this->m_heatmapFile, this->m_heatmapBins))
+        NS_LOG_UNCOND("Unable to write the heatmap " << this->m_heatmapFile);
+
+    if (this->m_failureReport)
+        this->m_failureStats.Report();
+
+    if (this->m_hotspots > 0)
+        this->m_failureStats.ReportHotspots(this->m_hotspots);
+
+    if (this->m_churn.IsEnabled())
+        this->m_churn.Report();
+
+    if (this->m_heightCache.IsEnabled())
+        this->m_heightCache.Report();
+
+    if (this->m_predictive)
+    {
+        NS_LOG_UNCOND("Pre-emptive reversals:\t" << this->nodes.GetPreemptiveReversals());
+        NS_LOG_UNCOND("Total reversals:\t" << this->nodes.GetReversals());
+    }
+
+    // Without detection the report gives the baseline failure latency.
+    if (this->m_partitionDetection || this->m_failureReport)
+        this->printPartitions();
+
+    if (this->m_enableMonitor)
+    {
+        this->m_dagMonitor.Report();
+
+        if (!this->m_monitorFile.empty())
+            this->m_dagMonitor.WriteSamples(this->m_monitorFile);
+    }
+
     Simulator::Destroy();
 }
 
@@ -0,0 +1,270 @@
+#include "../include/sweep-driver.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+NS_LOG_COMPONENT_DEFINE("SweepDriver");
+
+void
+SweepDriver::SetSimulator(const std::string& simulator, const std::string& arguments)
+{
+    m_simulator = simulator;
+    m_arguments = arguments;
+}
+
+void
+SweepDriver::SetParameter(const std::string& name, const std::vector<std::string>& values)
+{
+    m_parameter = name;
+    m_values = values;
+}
+
+void
+SweepDriver::SetMetrics(const std::vector<std::string>& metrics)
+{
+    m_metrics = metrics;
+}
+
+void
+SweepDriver::SetTarget(double width, double relativeWidth, uint32_t minRuns, uint32_t maxRuns)
+{
+    m_width = width;
+    m_relativeWidth = relativeWidth;
+    m_minRuns = std::max(minRuns, 2u);
+    m_maxRuns = std::max(maxRuns, m_minRuns);
+}
+
+void
+SweepDriver::SetDropZero(bool dropZero)
+{
+    m_dropZero = dropZero;
+}
+
+double
+SweepDriver::StudentT95(uint32_t degrees)
+{
+    static const double quantiles[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                       2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                       2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                       2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+
+    // Beyond 30 degrees the quantile is almost linear in 1 / degrees, so the sparse entries of
+    // the table are interpolated on that scale, down to the normal quantile at infinity.
+    static const double tail[][2] = {{30, 2.042}, {40, 2.021}, {60, 2.000}, {120, 1.980}};
+
+    if (degrees == 0)
+        return INFINITY;
+
+    if (degrees <= 30)
+        return quantiles[degrees - 1];
+
+    for (uint32_t i = 1; i < sizeof(tail) / sizeof(tail[0]); i++)
+    {
+        if (degrees <= tail[i][0])
+        {
+            double share = (1 / tail[i - 1][0] - 1.0 / degrees) /
+                           (1 / tail[i - 1][0] - 1 / tail[i][0]);
+            return tail[i - 1][1] + share * (tail[i][1] - tail[i - 1][1]);
+        }
+    }
+
+    return 1.960 + (1.980 - 1.960) * 120.0 / degrees;
+}
+
+SweepDriver::Statistic
+SweepDriver::Summarize(const std::vector<double>& samples)
+{
+    Statistic statistic;
+    statistic.runs = samples.size();
+
+    if (samples.empty())
+        return statistic;
+
+    double sum = 0;
+    for (double sample : samples)
+    {
+        sum += sample;
+    }
+    statistic.mean = sum / samples.size();
+
+    if (samples.size() < 2)
+    {
+        statistic.halfWidth = INFINITY;
+        return statistic;
+    }
+
+    double squares = 0;
+    for (double sample : samples)
+    {
+        squares += std::pow(sample - statistic.mean, 2);
+    }
+
+    double deviation = std::sqrt(squares / (samples.size() - 1));
+    statistic.halfWidth = StudentT95(samples.size() - 1) * deviation / std::sqrt(samples.size());
+
+    return statistic;
+}
+
+bool
+SweepDriver::RunOnce(const std::string& command,
+                     std::map<std::string, double>& results,
+                     std::string& output) const
+{
+    FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+    if (pipe == nullptr)
+    {
+        NS_LOG_ERROR("Unable to run " << command);
+        return false;
+    }
+
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr)
+    {
+        std::string line(buffer);
+        output += line;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+
+        std::string name = line.substr(0, colon);
+        for (const std::string& metric : m_metrics)
+        {
+            if (name != metric)
+                continue;
+
+            char* end = nullptr;
+            double value = std::strtod(line.c_str() + colon + 1, &end);
+            if (end != line.c_str() + colon + 1)
+                results[metric] = value;
+        }
+    }
+
+    if (pclose(pipe) != 0)
+    {
+        NS_LOG_WARN("Non-zero exit status from " << command);
+        return false;
+    }
+
+    for (const std::string& metric : m_metrics)
+    {
+        auto result = results.find(metric);
+        if (result == results.end() || (m_dropZero && result->second == 0))
+            return false;
+    }
+
+    return true;
+}
+
+bool
+SweepDriver::IsPrecise(const std::map<std::string, std::vector<double>>& samples) const
+{
+    for (const auto& [metric, values] : samples)
+    {
+        Statistic statistic = Summarize(values);
+        double target = (m_width > 0) ? m_width : m_relativeWidth * std::abs(statistic.mean);
+
+        if (2 * statistic.halfWidth > target)
+            return false;
+    }
+
+    return true;
+}
+
+std::vector<SweepDriver::Point>
+SweepDriver::Run()
+{
+    std::vector<Point> points;
+
+    for (const std::string& value : m_values)
+    {
+        Point point;
+        point.value = value;
+
+        std::map<std::string, std::vector<double>> samples;
+        for (const std::string& metric : m_metrics)
+        {
+            samples[metric];
+        }
+
+        // Every point uses the same sequence of seeds, so the points are compared on the same
+        // random scenarios.
+        for (uint32_t seed = 1; seed <= m_maxRuns; seed++)
+        {
+            std::string command = m_simulator + " " + m_arguments + " --" + m_parameter + "=" +
+                                  value + " --RngRun=" + std::to_string(seed);
+
+            std::map<std::string, double> results;
+            std::string output;
+            if (!RunOnce(command, results, output))
+            {
+                point.discarded++;
+
+                // The simulator rejects an invalid configuration with a message and exits 0,
+                // every other seed would be rejected the same way.
+                if (seed == 1 && results.empty())
+                {
+                    if (!output.empty() && output.back() == '\n')
+                        output.pop_back();
+
+                    NS_LOG_UNCOND("No metric in the output of " << command << ", skipping "
+                                                                << m_parameter << "=" << value
+                                                                << ":\n"
+                                                                << output);
+                    break;
+                }
+                continue;
+            }
+
+            for (const auto& [metric, result] : results)
+            {
+                samples[metric].push_back(result);
+            }
+
+            if (samples.begin()->second.size() >= m_minRuns && IsPrecise(samples))
+                break;
+        }
+
+        std::string line = m_parameter + "=" + value;
+        for (const auto& [metric, values] : samples)
+        {
+            Statistic statistic = Summarize(values);
+            point.metrics[metric] = statistic;
+            line += "\t" + metric + ": " + std::to_string(statistic.mean) + " +- " +
+                    std::to_string(statistic.halfWidth) + " (" + std::to_string(statistic.runs) +
+                    " runs)";
+        }
+        line += "\tdiscarded: " + std::to_string(point.discarded);
+
+        NS_LOG_UNCOND(line);
+        points.push_back(point);
+    }
+
+    return points;
+}
+
+void
+SweepDriver::WriteCsv(const std::string& filename, const std::vector<Point>& points) const
+{
+    std::ofstream out(filename);
+    if (!out.is_open())
+    {
+        NS_LOG_ERROR("Unable to open " << filename);
+        return;
+    }
+
+    out << m_parameter << ",metric,runs,mean,ci95_half_width,discarded\n";
+    for (const Point& point : points)
+    {
+        for (const auto& [metric, statistic] : point.metrics)
+        {
+            out << point.value << "," << metric << "," << statistic.runs << "," << statistic.mean
+                << "," << statistic.halfWidth << "," << point.discarded << "\n";
+        }
+    }
+}